@@ -0,0 +1,111 @@
+// Copyright 2006-2015 Tobias Sargeant (tobias.sargeant@gmail.com).
+//
+// This file is part of the Carve CSG Library (http://carve-csg.com/)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace carve {
+	// block_pool: per-thread cache of freed memory blocks of one size, used by the class specific operator new/delete of the mesh Edge and Face.
+	// CSG, clone() and mesh creation allocate and free many thousands of these small objects; reusing the blocks of the calling thread avoids most
+	// calls into the global allocator and its locking between threads. Blocks are independent allocations, so a block may be freed by another thread
+	// than the one that allocated it. The cache of each thread is bounded, released when the thread ends, and can be released earlier with trim().
+	template <size_t block_size>
+	class block_pool {
+		struct free_block {
+			free_block* next;
+		};
+
+		// trivially destructible, so that it can still be used after the cache of the thread has been released
+		struct thread_cache {
+			free_block* head;
+			size_t count;
+			bool released;
+		};
+
+		struct thread_cache_release {
+			~thread_cache_release() {
+				thread_cache& cache = s_cache;
+				while( cache.head ) {
+					free_block* next = cache.head->next;
+					::operator delete(cache.head);
+					cache.head = next;
+				}
+				cache.count = 0;
+				cache.released = true;
+			}
+		};
+
+		// for the 3D mesh on 64 bit (48 byte edges, 88 byte faces) this keeps at most about 550 KB per thread. A larger cap did not make CSG faster
+		static constexpr size_t max_cached_blocks = 4096;
+		static inline thread_local thread_cache s_cache = { nullptr, 0, false };
+		static inline thread_local thread_cache_release s_cache_release;
+
+	public:
+		static_assert(block_size >= sizeof(free_block), "block_pool: block too small");
+
+		static void* allocate(size_t size) {
+			thread_cache& cache = s_cache;
+			if( size == block_size && cache.head ) {
+				free_block* block = cache.head;
+				cache.head = block->next;
+				--cache.count;
+				return block;
+			}
+			return ::operator new(size);
+		}
+
+		// trim: returns the cached blocks of the calling thread to the global allocator, for example when a long living thread becomes idle
+		static void trim() {
+			thread_cache& cache = s_cache;
+			while( cache.head ) {
+				free_block* next = cache.head->next;
+				::operator delete(cache.head);
+				cache.head = next;
+			}
+			cache.count = 0;
+		}
+
+		static void release(void* p, size_t size) {
+			if( !p ) {
+				return;
+			}
+			thread_cache& cache = s_cache;
+			if( size == block_size && cache.count < max_cached_blocks && !cache.released ) {
+				if( cache.count == 0 ) {
+					// touch the releaser, so that it is constructed and frees the cache at thread exit
+					(void)&s_cache_release;
+				}
+				free_block* block = static_cast<free_block*>(p);
+				block->next = cache.head;
+				cache.head = block;
+				++cache.count;
+				return;
+			}
+			::operator delete(p);
+		}
+	};
+}  // namespace carve
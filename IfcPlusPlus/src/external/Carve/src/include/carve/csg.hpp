@@ -25,6 +25,7 @@
 #pragma once
 
 #include <algorithm>
+#include <functional>
 #include <list>
 #include <vector>
 
@@ -168,20 +169,42 @@ namespace carve {
 
 			void groupIntersections();
 
-			void _generateVertexVertexIntersections(meshset_t::vertex_t* va, meshset_t::edge_t* eb);
-			void generateVertexVertexIntersections( meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b);
+			/// Pairs of intersection objects that were found to intersect, but not recorded yet.
+			template <typename obj_t>
+			using deferred_t = std::vector<std::pair<obj_t*, meshset_t::edge_t*> >;
 
-			void _generateVertexEdgeIntersections(meshset_t::vertex_t* va, meshset_t::edge_t* eb);
-			void generateVertexEdgeIntersections( meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b);
+			// If deferred is given, an intersection is appended to it instead of being
+			// recorded. Intersections and vertex_pool are not modified then, so that
+			// different face pairs can be processed concurrently.
 
-			void _generateEdgeEdgeIntersections(meshset_t::edge_t* ea, meshset_t::edge_t* eb);
-			void generateEdgeEdgeIntersections(meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b);
+			void _generateVertexVertexIntersections(meshset_t::vertex_t* va, meshset_t::edge_t* eb, deferred_t<meshset_t::vertex_t>* deferred = nullptr);
+			void generateVertexVertexIntersections( meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b, deferred_t<meshset_t::vertex_t>* deferred = nullptr);
 
-			void _generateVertexFaceIntersections(meshset_t::face_t* fa, meshset_t::edge_t* eb);
-			void generateVertexFaceIntersections( meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b);
+			void _generateVertexEdgeIntersections(meshset_t::vertex_t* va, meshset_t::edge_t* eb, deferred_t<meshset_t::vertex_t>* deferred = nullptr);
+			void generateVertexEdgeIntersections( meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b, deferred_t<meshset_t::vertex_t>* deferred = nullptr);
 
-			void _generateEdgeFaceIntersections(meshset_t::face_t* fa, meshset_t::edge_t* eb);
-			void generateEdgeFaceIntersections(meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b);
+			void _generateEdgeEdgeIntersections(meshset_t::edge_t* ea, meshset_t::edge_t* eb, deferred_t<meshset_t::edge_t>* deferred = nullptr);
+			void generateEdgeEdgeIntersections(meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b, deferred_t<meshset_t::edge_t>* deferred = nullptr);
+
+			void _generateVertexFaceIntersections(meshset_t::face_t* fa, meshset_t::edge_t* eb, deferred_t<meshset_t::face_t>* deferred = nullptr);
+			void generateVertexFaceIntersections( meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b, deferred_t<meshset_t::face_t>* deferred = nullptr);
+
+			void _generateEdgeFaceIntersections(meshset_t::face_t* fa, meshset_t::edge_t* eb, deferred_t<meshset_t::face_t>* deferred = nullptr);
+			void generateEdgeFaceIntersections(meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b, deferred_t<meshset_t::face_t>* deferred = nullptr);
+
+			/**
+			 * \brief Run one of the generate*Intersections() passes over all face pairs.
+			 *
+			 * With parallel_for set, the face pairs are split into chunks that are
+			 * tested concurrently against the intersections of the previous passes.
+			 * The deferred intersections are then recorded serially, chunk by chunk,
+			 * so the result is the same as that of the serial pass.
+			 */
+			template <typename obj_t>
+			void generateIntersectionsPass(
+				const std::vector<const face_pairs_t::value_type*>& face_pairs,
+				void (CSG::*generate_face)(meshset_t::face_t*, const std::vector<meshset_t::face_t*>&, deferred_t<obj_t>*),
+				void (CSG::*generate)(obj_t*, meshset_t::edge_t*, deferred_t<obj_t>*));
 
 			void generateIntersectionCandidates(meshset_t* a, const face_rtree_t* a_node, meshset_t* b, const face_rtree_t* b_node, face_pairs_t& face_pairs, bool descend_a = true);
 			/**
@@ -353,9 +376,18 @@ namespace carve {
 				CLASSIFY_EDGE    /**< Edge classifier. */
 			};
 
+			/**
+			 * \brief Calls the given function for each index in [0, n), possibly in parallel.
+			 * Returns when all calls are done. The function does not throw.
+			 */
+			typedef std::function<void(size_t n, const std::function<void(size_t)>& func)> parallel_for_t;
+
 			CSG::Hooks hooks; /**< The manager for calculation hooks. */
 			double m_epsilon;
 
+			/// If set, the intersection tests of face pairs are distributed with it. Unset: serial.
+			parallel_for_t parallel_for;
+
 			CSG(double _CARVE_EPSILON);
 			~CSG();
 
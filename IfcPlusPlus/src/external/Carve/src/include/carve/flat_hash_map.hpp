@@ -0,0 +1,218 @@
+// Copyright 2006-2015 Tobias Sargeant (tobias.sargeant@gmail.com).
+//
+// This file is part of the Carve CSG Library (http://carve-csg.com/)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace carve {
+	// flat_hash_map: hash map for the temporary lookup tables of the CSG and mesh construction, in place of std::unordered_map.
+	// The entries are stored in insertion order in one vector, and an open addressing table with linear probing holds their
+	// indices. Inserts do not allocate a node per entry, and iteration is in insertion order, so it does not depend on pointer
+	// values of the keys. Erasing moves the last entry into the erased position.
+	// Unlike std::unordered_map, inserting or erasing invalidates all iterators and references to entries.
+	template <typename key_t, typename mapped_t, typename hash_t = std::hash<key_t>, typename equal_t = std::equal_to<key_t> >
+	class flat_hash_map {
+	public:
+		typedef key_t key_type;
+		typedef mapped_t mapped_type;
+		typedef std::pair<key_t, mapped_t> value_type;
+		typedef typename std::vector<value_type>::iterator iterator;
+		typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+	private:
+		std::vector<value_type> m_entries;
+		std::vector<uint32_t> m_slots;	// 0: empty, otherwise index into m_entries + 1
+		size_t m_mask = 0;
+		unsigned m_shift = 64;
+		hash_t m_hash;
+		equal_t m_equal;
+
+		size_t home(const key_t& key) const {
+			// Fibonacci hashing, takes the high bits, so that hashes of aligned pointers spread over the table
+			return size_t((uint64_t(m_hash(key)) * 0x9E3779B97F4A7C15ull) >> m_shift);
+		}
+
+		size_t slotOf(const key_t& key) const {
+			if( m_slots.empty() ) {
+				return SIZE_MAX;
+			}
+			size_t i = home(key);
+			while( m_slots[i] ) {
+				if( m_equal(m_entries[m_slots[i] - 1].first, key) ) {
+					return i;
+				}
+				i = (i + 1) & m_mask;
+			}
+			return SIZE_MAX;
+		}
+
+		size_t slotOfEntry(size_t entry) const {
+			size_t i = home(m_entries[entry].first);
+			while( m_slots[i] != entry + 1 ) {
+				i = (i + 1) & m_mask;
+			}
+			return i;
+		}
+
+		void rehash(size_t capacity) {
+			unsigned bits = 4;
+			while( (size_t(1) << bits) < capacity ) {
+				++bits;
+			}
+			m_slots.assign(size_t(1) << bits, 0);
+			m_mask = m_slots.size() - 1;
+			m_shift = 64 - bits;
+			for( size_t entry = 0; entry < m_entries.size(); ++entry ) {
+				size_t i = home(m_entries[entry].first);
+				while( m_slots[i] ) {
+					i = (i + 1) & m_mask;
+				}
+				m_slots[i] = uint32_t(entry + 1);
+			}
+		}
+
+		// slot for a key that is not in the map, grows the table if needed
+		size_t freeSlot(const key_t& key) {
+			if( (m_entries.size() + 1) * 2 > m_slots.size() ) {
+				rehash((m_entries.size() + 1) * 2);
+			}
+			size_t i = home(key);
+			while( m_slots[i] ) {
+				i = (i + 1) & m_mask;
+			}
+			return i;
+		}
+
+	public:
+		flat_hash_map() {}
+
+		explicit flat_hash_map(size_t expected_size) {
+			reserve(expected_size);
+		}
+
+		void reserve(size_t expected_size) {
+			m_entries.reserve(expected_size);
+			if( expected_size * 2 > m_slots.size() ) {
+				rehash(expected_size * 2);
+			}
+		}
+
+		size_t size() const { return m_entries.size(); }
+		bool empty() const { return m_entries.empty(); }
+
+		void clear() {
+			m_entries.clear();
+			m_slots.clear();
+			m_mask = 0;
+			m_shift = 64;
+		}
+
+		iterator begin() { return m_entries.begin(); }
+		iterator end() { return m_entries.end(); }
+		const_iterator begin() const { return m_entries.begin(); }
+		const_iterator end() const { return m_entries.end(); }
+
+		iterator find(const key_t& key) {
+			size_t i = slotOf(key);
+			return i == SIZE_MAX ? end() : begin() + (m_slots[i] - 1);
+		}
+
+		const_iterator find(const key_t& key) const {
+			size_t i = slotOf(key);
+			return i == SIZE_MAX ? end() : begin() + (m_slots[i] - 1);
+		}
+
+		size_t count(const key_t& key) const {
+			return slotOf(key) == SIZE_MAX ? 0 : 1;
+		}
+
+		std::pair<iterator, bool> insert(const value_type& value) {
+			size_t i = slotOf(value.first);
+			if( i != SIZE_MAX ) {
+				return std::make_pair(begin() + (m_slots[i] - 1), false);
+			}
+			i = freeSlot(value.first);
+			m_entries.push_back(value);
+			m_slots[i] = uint32_t(m_entries.size());
+			return std::make_pair(end() - 1, true);
+		}
+
+		mapped_t& operator[](const key_t& key) {
+			size_t i = slotOf(key);
+			if( i != SIZE_MAX ) {
+				return m_entries[m_slots[i] - 1].second;
+			}
+			i = freeSlot(key);
+			m_entries.push_back(value_type(key, mapped_t()));
+			m_slots[i] = uint32_t(m_entries.size());
+			return m_entries.back().second;
+		}
+
+		// returns the iterator to the entry that took the place of the erased one
+		iterator erase(const_iterator pos) {
+			const size_t entry = size_t(pos - m_entries.cbegin());
+
+			// backward shift deletion, keeps the probe sequences of the other keys intact
+			size_t i = slotOfEntry(entry);
+			size_t j = i;
+			while( true ) {
+				j = (j + 1) & m_mask;
+				if( !m_slots[j] ) {
+					break;
+				}
+				const size_t k = home(m_entries[m_slots[j] - 1].first);
+				// move j to the hole at i, unless its home slot is cyclically in (i, j]
+				const bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+				if( !stays ) {
+					m_slots[i] = m_slots[j];
+					i = j;
+				}
+			}
+			m_slots[i] = 0;
+
+			const size_t last = m_entries.size() - 1;
+			if( entry != last ) {
+				m_slots[slotOfEntry(last)] = uint32_t(entry + 1);
+				m_entries[entry] = std::move(m_entries[last]);
+			}
+			m_entries.pop_back();
+			return begin() + entry;
+		}
+
+		size_t erase(const key_t& key) {
+			size_t i = slotOf(key);
+			if( i == SIZE_MAX ) {
+				return 0;
+			}
+			erase(begin() + (m_slots[i] - 1));
+			return 1;
+		}
+	};
+}  // namespace carve
@@ -40,9 +40,7 @@
 #include <iostream>
 #endif
 
-#if defined CARVE_USE_EXACT_PREDICATES
-#include <carve/shewchuk_predicates.hpp>
-#endif
+#include <carve/robust_predicates.hpp>
 
 namespace carve {
 	namespace geom2d {
@@ -61,7 +59,7 @@ namespace carve {
 		/**
 		 * \brief Return the orientation of c with respect to the ray defined by a->b.
 		 *
-		 * (Can be implemented exactly)
+		 * The sign is exact, see carve::robust::orient2d.
 		 *
 		 * @param[in] a
 		 * @param[in] b
@@ -71,19 +69,9 @@ namespace carve {
 		 *         zero, if c is colinear with a->b.
 		 *         negative, if c to the right of a->b.
 		 */
-#if defined CARVE_USE_EXACT_PREDICATES
-		inline double orient2d(const P2& a, const P2& b, const P2& c) {
-			return shewchuk::orient2d(a.v, b.v, c.v);
-		}
-#else
 		inline double orient2d(const P2& a, const P2& b, const P2& c) {
-			double acx = a.x - c.x;
-			double bcx = b.x - c.x;
-			double acy = a.y - c.y;
-			double bcy = b.y - c.y;
-			return acx * bcy - acy * bcx;
+			return carve::robust::orient2d(a.v, b.v, c.v);
 		}
-#endif
 
 		/**
 		 * \brief Determine whether p is internal to the anticlockwise
@@ -38,9 +38,7 @@
 #include <iostream>
 #endif
 
-#if defined CARVE_USE_EXACT_PREDICATES
-#include <carve/shewchuk_predicates.hpp>
-#endif
+#include <carve/robust_predicates.hpp>
 
 namespace carve {
 	namespace geom3d {
@@ -201,17 +199,10 @@ namespace carve {
 		// return: +ve = d is below a,b,c
 		//         -ve = d is above a,b,c
 		//           0 = d is on a,b,c
-#if defined CARVE_USE_EXACT_PREDICATES
-		inline double orient3d(const Vector& a, const Vector& b, const Vector& c,
-			const Vector& d) {
-			return shewchuk::orient3d(a.v, b.v, c.v, d.v);
-		}
-#else
 		inline double orient3d(const Vector& a, const Vector& b, const Vector& c, const Vector& d)
 		{
-			return dotcross((a - d), (b - d), (c - d));
+			return carve::robust::orient3d(a.v, b.v, c.v, d.v);
 		}
-#endif
 
 		// Volume of a tetrahedron described by 4 points. Will be
 		// positive if the anticlockwise normal of a,b,c is oriented out
@@ -283,21 +274,14 @@ namespace carve {
 			// double d3 = carve::geom3d::orient3d(carve::geom::VECTOR(0,0,0), direction,
 			// base, b);
 
-#if defined(CARVE_USE_EXACT_PREDICATES)
-  // which is equivalent to the following (which eliminates a
-  // vector subtraction):
+			// which is equivalent to the following (which eliminates a
+			// vector subtraction):
 			double d1 =
 				carve::geom3d::orient3d(direction, b, a, carve::geom::VECTOR(0, 0, 0));
 			double d2 =
 				carve::geom3d::orient3d(direction, a, base, carve::geom::VECTOR(0, 0, 0));
 			double d3 =
 				carve::geom3d::orient3d(direction, b, base, carve::geom::VECTOR(0, 0, 0));
-#else
-  // dotcross = a . (b x c)
-			double d1 = carve::geom::dotcross(direction, b, a);
-			double d2 = carve::geom::dotcross(direction, a, base);
-			double d3 = carve::geom::dotcross(direction, b, base);
-#endif
 
 			if (isnan(d1) || isnan(d2) || isnan(d3))
 			{
@@ -387,11 +371,13 @@ namespace carve {
 				}
 			}
 			else {
+				// atan2 keeps full precision for angles close to 0 and pi, where acos(dp) does not
+				double angle = atan2(cp.length(), dp);
 				if( dot(cp, orient) > 0.0 ) {
-					return acos(dp);
+					return angle;
 				}
 				else {
-					return M_TWOPI - acos(dp);
+					return M_TWOPI - angle;
 				}
 			}
 		}
@@ -27,13 +27,18 @@
 #include <carve/carve.hpp>
 
 #include <carve/aabb.hpp>
+#include <carve/block_pool.hpp>
 #include <carve/djset.hpp>
 #include <carve/geom.hpp>
 #include <carve/geom3d.hpp>
+#include <carve/flat_hash_map.hpp>
+#include <carve/pointer_map.hpp>
 #include <carve/rtree.hpp>
 #include <carve/tag.hpp>
 
 #include <iostream>
+#include <memory>
+#include <mutex>
 
 #if defined _DEBUG || defined _DEBUG_RELEASE
 static long globalNumMeshSets = 0;
@@ -240,6 +245,9 @@ namespace carve {
 			Edge(vertex_t* _vert, face_t* _face);
 
 			~Edge();
+
+			static void* operator new(size_t size) { return block_pool<sizeof(Edge)>::allocate(size); }
+			static void operator delete(void* p, size_t size) { block_pool<sizeof(Edge)>::release(p, size); }
 		};
 
 		// A Face contains a pointer to the beginning of the half-edge
@@ -424,7 +432,7 @@ namespace carve {
 			template <typename iter_t>
 			Face* create(iter_t beg, iter_t end, bool reversed) const;
 
-			Face* clone(const vertex_t* old_base, vertex_t* new_base, std::unordered_map<const edge_t*, edge_t*>& edge_map) const;
+			Face* clone(const vertex_t* old_base, vertex_t* new_base, pointer_map<edge_t, edge_t*>& edge_map) const;
 
 			void remove() {
 				edge_t* e = edge;
@@ -472,8 +480,17 @@ namespace carve {
 			void canonicalize();
 
 			~Face() { clearEdges(); }
+
+			static void* operator new(size_t size) { return block_pool<sizeof(Face)>::allocate(size); }
+			static void operator delete(void* p, size_t size) { block_pool<sizeof(Face)>::release(p, size); }
 		};
 
+		// release_cached_blocks: returns the edges and faces freed and cached by the calling thread to the global allocator
+		inline void release_cached_blocks() {
+			block_pool<sizeof(Edge<3>)>::trim();
+			block_pool<sizeof(Face<3>)>::trim();
+		}
+
 		struct MeshOptions {
 			bool opt_avoid_cavities;
 
@@ -496,14 +513,17 @@ namespace carve {
 				typedef Face<3> face_t;
 
 				typedef std::pair<const vertex_t*, const vertex_t*> vpair_t;
-				typedef std::list<edge_t*> edgelist_t;
-				typedef std::unordered_map<vpair_t, edgelist_t, carve::mesh::hash_vertex_pair> edge_map_t;
+				typedef std::vector<edge_t*> edgelist_t;
+				// all edges, built once per stitched mesh
+				typedef carve::flat_hash_map<vpair_t, edgelist_t, carve::mesh::hash_vertex_pair> edge_map_t;
+				// edges with more than one face on a side, entries are erased while iterators to others are held
+				typedef std::unordered_map<vpair_t, edgelist_t, carve::mesh::hash_vertex_pair> complex_edge_map_t;
 				typedef std::unordered_map<const vertex_t*, std::set<const vertex_t*> > edge_graph_t;
 
 				MeshOptions opts;
 
 				edge_map_t edges;
-				edge_map_t complex_edges;
+				complex_edge_map_t complex_edges;
 
 				carve::djset::djset face_groups;
 				std::vector<bool> is_open;
@@ -580,7 +600,7 @@ namespace carve {
 					const vpair_t& e, const edge_map_t& all_edges,
 					std::pair<std::set<size_t>, std::set<size_t> >& groups);
 
-				void buildEdgeGraph(const edge_map_t& all_edges);
+				void buildEdgeGraph(const complex_edge_map_t& all_edges);
 				void extractPath(std::vector<const vertex_t*>& path);
 				void removePath(const std::vector<const vertex_t*>& path);
 				void matchSimpleEdges();
@@ -634,7 +654,12 @@ namespace carve {
 			bool is_inner_mesh = false;  // completely inside other mesh
 
 			meshset_t* meshset = nullptr;
+			// Signed volume, surface area and bounding box of the faces, computed together by updateMetrics().
+			// m_volume is NaN while they are not valid. recalc() and invert() reset them, code that moves
+			// vertices without recalc() has to call resetVolume().
 			double m_volume = std::numeric_limits<double>::quiet_NaN();
+			double m_surface_area = 0.0;
+			aabb_t m_metrics_aabb;
 			void resetVolume() { m_volume = std::numeric_limits<double>::quiet_NaN(); }
 
 		protected:
@@ -654,31 +679,38 @@ namespace carve {
 
 			bool isNegative() const { return is_negative; }
 
+			void updateMetrics();
+
 			double volume()
 			{
 				if (is_negative || !faces.size()) {
 					return 0.0;
 				}
 
-				if (!std::isnan(m_volume))
+				if (std::isnan(m_volume))
 				{
-					return m_volume;
+					updateMetrics();
 				}
+				return m_volume;
+			}
 
-				double vol = 0.0;
-				typename vertex_t::vector_t origin = faces[0]->edge->vert->v;
+			double surfaceArea()
+			{
+				if (std::isnan(m_volume))
+				{
+					updateMetrics();
+				}
+				return m_surface_area;
+			}
 
-				for (size_t f = 0; f < faces.size(); ++f)
+			// same as getAABB(), but taken from the cached metrics
+			const aabb_t& metricsAABB()
+			{
+				if (std::isnan(m_volume))
 				{
-					face_t* face = faces[f];
-					edge_t* e1 = face->edge;
-					for (edge_t* e2 = e1->next; e2->next != e1; e2 = e2->next)
-					{
-						vol += carve::geom3d::tetrahedronVolume(e1->vert->v, e2->vert->v, e2->next->vert->v, origin);
-					}
+					updateMetrics();
 				}
-				m_volume = vol;
-				return vol;
+				return m_metrics_aabb;
 			}
 
 			struct IsClosed {
@@ -703,6 +735,7 @@ namespace carve {
 					faces[i]->recalc(CARVE_EPSILON);
 				}
 				calcOrientation();
+				resetVolume();
 			}
 
 			void invert()
@@ -715,6 +748,7 @@ namespace carve {
 				{
 					is_negative = !is_negative;
 				}
+				resetVolume();
 			}
 
 			Mesh* clone(const vertex_t* old_base, vertex_t* new_base) const;
@@ -737,6 +771,14 @@ namespace carve {
 			typedef Face<ndim> face_t;
 			typedef Mesh<ndim> mesh_t;
 			typedef carve::geom::aabb<ndim> aabb_t;
+			typedef carve::geom::RTreeNode<ndim, face_t*> face_rtree_t;
+
+		private:
+			// bounding volume hierarchy of all faces, see faceTree()
+			std::unique_ptr<face_rtree_t> face_tree;
+			std::mutex face_tree_mutex;
+
+		public:
 
 			std::vector<vertex_t> vertex_storage;
 			std::vector<mesh_t*> meshes;
@@ -836,8 +878,23 @@ namespace carve {
 				for( size_t i = 0; i < meshes.size(); ++i ) {
 					meshes[i]->recalc();
 				}
+				refitFaceTree();
 			}
 
+			// Bounding volume hierarchy of all faces. It is built on first use and kept, so that
+			// consecutive boolean operations and point classifications with this mesh set share it.
+			// Code that adds or removes faces must call invalidateFaceTree(), code that only moves
+			// vertices may call refitFaceTree() instead, which keeps the tree structure. Both also reset the
+			// cached metrics of the meshes, see Mesh::updateMetrics(). releaseFaceTree() frees the tree of an
+			// unchanged mesh set that is kept, but not used in further boolean operations.
+			const face_rtree_t* faceTree();
+
+			void invalidateFaceTree();
+
+			void refitFaceTree();
+
+			void releaseFaceTree();
+
 			MeshSet(const std::vector<typename vertex_t::vector_t>& points, size_t n_faces, const std::vector<int>& face_indices, double CARVE_EPSILON, const MeshOptions& opts = MeshOptions());
 
 			// Construct a mesh set from a set of disconnected faces. Takes possession of the face pointers.
@@ -697,7 +697,7 @@ Face<ndim>* Face<ndim>::create(iter_t beg, iter_t end, bool reversed) const
 }
 
 template <unsigned int ndim>
-Face<ndim>* Face<ndim>::clone(const vertex_t* old_base, vertex_t* new_base, std::unordered_map<const edge_t*, edge_t*>& edge_map) const
+Face<ndim>* Face<ndim>::clone(const vertex_t* old_base, vertex_t* new_base, pointer_map<edge_t, edge_t*>& edge_map) const
 {
     Face* r = new Face(*this);
 
@@ -706,7 +706,7 @@ Face<ndim>* Face<ndim>::clone(const vertex_t* old_base, vertex_t* new_base, std:
     edge_t* r_e;
     do {
         r_e = new edge_t(e->vert - old_base + new_base, r);
-        edge_map[e] = r_e;
+        edge_map.insert(e, r_e);
         if (r_p) {
             r_p->next = r_e;
             r_e->prev = r_p;
@@ -717,11 +717,10 @@ Face<ndim>* Face<ndim>::clone(const vertex_t* old_base, vertex_t* new_base, std:
         r_p = r_e;
 
         if (e->rev) {
-            typename std::unordered_map<const edge_t*, edge_t*>::iterator rev_i =
-                edge_map.find(e->rev);
-            if (rev_i != edge_map.end()) {
-                r_e->rev = (*rev_i).second;
-                (*rev_i).second->rev = r_e;
+            edge_t* const* rev_i = edge_map.find(e->rev);
+            if (rev_i) {
+                r_e->rev = *rev_i;
+                (*rev_i)->rev = r_e;
             }
         }
 
@@ -899,6 +898,59 @@ inline int Mesh<3>::orientationAtVertex(edge_t* e_base)
     return 0;
 }
 
+template <unsigned int ndim>
+void Mesh<ndim>::updateMetrics()
+{
+    // One walk over the face loops. Volume and area use the same triangle fan per face, the volume
+    // terms are tetrahedra relative to the first vertex of the mesh.
+    typedef typename vertex_t::vector_t vector_t;
+    double vol = 0.0;
+    double area = 0.0;
+    vector_t vmin, vmax;
+    bool first = true;
+    vector_t origin;
+    if (faces.size()) {
+        origin = faces[0]->edge->vert->v;
+    }
+
+    for (size_t f = 0; f < faces.size(); ++f) {
+        face_t* face = faces[f];
+        edge_t* e1 = face->edge;
+        const vector_t& a = e1->vert->v;
+        vector_t area_vec = vector_t::ZERO();
+
+        edge_t* e = e1;
+        do {
+            const vector_t& v = e->vert->v;
+            if (first) {
+                vmin = vmax = v;
+                first = false;
+            } else {
+                for (unsigned i = 0; i < ndim; ++i) {
+                    if (v.v[i] < vmin.v[i]) vmin.v[i] = v.v[i];
+                    if (v.v[i] > vmax.v[i]) vmax.v[i] = v.v[i];
+                }
+            }
+            e = e->next;
+        } while (e != e1);
+
+        for (edge_t* e2 = e1->next; e2->next != e1; e2 = e2->next) {
+            const vector_t& b = e2->vert->v;
+            const vector_t& c = e2->next->vert->v;
+            vol += carve::geom3d::tetrahedronVolume(a, b, c, origin);
+            area_vec += carve::geom::cross(b - a, c - a);
+        }
+        area += area_vec.length() * 0.5;
+    }
+
+    m_metrics_aabb = aabb_t();
+    if (!first) {
+        m_metrics_aabb.fit(vmin, vmax);
+    }
+    m_surface_area = area;
+    m_volume = vol;
+}
+
 template <unsigned int ndim>
 void Mesh<ndim>::calcOrientation()
 {
@@ -967,17 +1019,28 @@ Mesh<ndim>* Mesh<ndim>::clone(const vertex_t* old_base, vertex_t* new_base) cons
     std::vector<face_t*> r_faces;
     std::vector<edge_t*> r_open_edges;
     std::vector<edge_t*> r_closed_edges;
-    std::unordered_map<const edge_t*, edge_t*> edge_map;
 
     r_faces.reserve(faces.size());
-    r_open_edges.reserve(r_open_edges.size());
-    r_closed_edges.reserve(r_closed_edges.size());
+    r_open_edges.reserve(open_edges.size());
+    r_closed_edges.reserve(closed_edges.size());
+
+    size_t num_edges = 0;
+    for (size_t i = 0; i < faces.size(); ++i)
+    {
+        num_edges += faces[i]->n_edges;
+    }
+    pointer_map<edge_t, edge_t*> edge_map(num_edges);
 
     for (size_t i = 0; i < faces.size(); ++i)
     {
         r_faces.push_back(faces[i]->clone(old_base, new_base, edge_map));
     }
-    
+
+    auto find_edge = [&edge_map](const edge_t* e) -> edge_t* {
+        edge_t* const* mapped = edge_map.find(e);
+        return mapped ? *mapped : nullptr;
+    };
+
     for (size_t i = 0; i < closed_edges.size(); ++i)
     {
         edge_t* closedEdge = closed_edges[i];
@@ -986,22 +1049,27 @@ Mesh<ndim>* Mesh<ndim>::clone(const vertex_t* old_base, vertex_t* new_base) cons
             continue;
         }
 
-        r_closed_edges.push_back(edge_map[closedEdge]);
+        r_closed_edges.push_back(find_edge(closedEdge));
 
         edge_t* r1 = r_closed_edges.back();
         if (r1 == nullptr)
         {
             continue;
         }
-        r1->rev = edge_map[closedEdge->rev];
+        r1->rev = find_edge(closedEdge->rev);
     }
-    
+
     for (size_t i = 0; i < open_edges.size(); ++i)
     {
-        r_open_edges.push_back(edge_map[open_edges[i]]);
+        r_open_edges.push_back(find_edge(open_edges[i]));
     }
 
     Mesh<ndim>* m = new Mesh(r_faces, r_open_edges, r_closed_edges, is_negative, is_inner_mesh);
+
+    // the clone has the same coordinates, the cached metrics stay valid
+    m->m_volume = m_volume;
+    m->m_surface_area = m_surface_area;
+    m->m_metrics_aabb = m_metrics_aabb;
     return m;
 }
 
@@ -1201,6 +1269,49 @@ MeshSet<ndim>* MeshSet<ndim>::clone() const
     return new MeshSet(r_vertex_storage, r_meshes);
 }
 
+template <unsigned int ndim>
+const typename MeshSet<ndim>::face_rtree_t* MeshSet<ndim>::faceTree()
+{
+    std::lock_guard<std::mutex> lock(face_tree_mutex);
+    if (!face_tree)
+    {
+        face_tree.reset(face_rtree_t::construct_STR(faceBegin(), faceEnd(), 4, 4));
+    }
+    return face_tree.get();
+}
+
+template <unsigned int ndim>
+void MeshSet<ndim>::invalidateFaceTree()
+{
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        meshes[i]->resetVolume();
+    }
+    std::lock_guard<std::mutex> lock(face_tree_mutex);
+    face_tree.reset();
+}
+
+template <unsigned int ndim>
+void MeshSet<ndim>::refitFaceTree()
+{
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        meshes[i]->resetVolume();
+    }
+    std::lock_guard<std::mutex> lock(face_tree_mutex);
+    if (face_tree)
+    {
+        face_tree->refit();
+    }
+}
+
+template <unsigned int ndim>
+void MeshSet<ndim>::releaseFaceTree()
+{
+    std::lock_guard<std::mutex> lock(face_tree_mutex);
+    face_tree.reset();
+}
+
 template <unsigned int ndim>
 MeshSet<ndim>::~MeshSet() {
   for (size_t i = 0; i < meshes.size(); ++i) {
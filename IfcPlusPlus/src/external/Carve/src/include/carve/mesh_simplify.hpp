@@ -1205,6 +1205,7 @@ namespace carve {
 			// Merge adjacent coplanar faces (where coplanar is determined by dot-product >= cos(min_normal_angle)).
 			size_t mergeCoplanarFaces(meshset_t* meshset, double min_normal_angle)
 			{
+				meshset->invalidateFaceTree();
 				size_t n_removed = 0;
 				for( size_t i = 0; i < meshset->meshes.size(); ++i ) {
 					n_removed += mergeCoplanarFaces(meshset->meshes[i], min_normal_angle);
@@ -1217,6 +1218,7 @@ namespace carve {
 
 			size_t improveMesh_conservative(meshset_t* meshset, double CARVE_EPSILON)
 			{
+				meshset->invalidateFaceTree();
 				initEdgeInfo(meshset);
 				size_t modifications = flipEdges(meshset, FlippableConservative(), CARVE_EPSILON);
 				clearEdgeInfo();
@@ -1225,6 +1227,7 @@ namespace carve {
 
 			size_t improveMesh(meshset_t* meshset, double min_colinearity, double min_delta_v, double min_normal_angle, double CARVE_EPSILON)
 			{
+				meshset->invalidateFaceTree();
 				initEdgeInfo(meshset);
 				size_t modifications = flipEdges( meshset, Flippable(min_colinearity, min_delta_v, min_normal_angle), CARVE_EPSILON);
 				clearEdgeInfo();
@@ -1232,6 +1235,7 @@ namespace carve {
 			}
 
 			size_t eliminateShortEdges(meshset_t* meshset, double min_length) {
+				meshset->invalidateFaceTree();
 				initEdgeInfo(meshset);
 				size_t modifications = collapseEdges(meshset, EdgeMerger(min_length));
 				removeRemnantFaces(meshset);
@@ -1246,6 +1250,7 @@ namespace carve {
 			// performed).
 			void snap(meshset_t* meshset, int log2_grid, double CARVE_EPSILON, int angle_xy_quantization = 0, int angle_z_quantization = 0)
 			{
+				meshset->invalidateFaceTree();
 				double grid = 0.0;
 				if( log2_grid >= std::numeric_limits<double>::min_exponent ) {
 					grid = pow(2.0, (double)log2_grid);
@@ -1391,6 +1396,7 @@ namespace carve {
 
 			size_t simplify(meshset_t* meshset, double min_colinearity, double min_delta_v, double min_normal_angle, double min_length, double CARVE_EPSILON)
 			{
+				meshset->invalidateFaceTree();
 				size_t modifications = 0;
 				size_t n, n_flip, n_merge;
 
@@ -1464,6 +1470,7 @@ namespace carve {
 			}
 
 			size_t removeFins(meshset_t* meshset) {
+				meshset->invalidateFaceTree();
 				size_t n_removed = 0;
 				for( size_t i = 0; i < meshset->meshes.size(); ++i ) {
 					n_removed += removeFins(meshset->meshes[i]);
@@ -1472,6 +1479,7 @@ namespace carve {
 			}
 
 			size_t removeLowVolumeManifolds(meshset_t* meshset, double min_abs_volume) {
+				meshset->invalidateFaceTree();
 				size_t n_removed = 0;
 				for( size_t i = 0; i < meshset->meshes.size(); ++i ) {
 					if( fabs(meshset->meshes[i]->volume()) < min_abs_volume ) {
@@ -1580,6 +1588,7 @@ namespace carve {
 			};
 
 			void selfIntersectionAwareQuantize(meshset_t* meshset, int base, int n_dp) {
+				meshset->invalidateFaceTree();
 				typedef std::unordered_map<vertex_t*, quantization_info_t> vfsmap_t;
 
 				vfsmap_t vertex_qinfo;
@@ -0,0 +1,113 @@
+// Copyright 2006-2015 Tobias Sargeant (tobias.sargeant@gmail.com).
+//
+// This file is part of the Carve CSG Library (http://carve-csg.com/)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace carve {
+	// pointer_map: insert-only open addressing hash map with pointer keys, for temporary old -> new mappings (e.g. in Mesh::clone).
+	// All entries are in one array, so inserts do not allocate and a lookup touches one or two cache lines, compared to a node
+	// allocation and a pointer chase per entry in std::unordered_map. nullptr can not be used as key.
+	template <typename key_t, typename value_t>
+	class pointer_map {
+		std::vector<std::pair<const key_t*, value_t> > m_slots;
+		size_t m_mask = 0;
+		size_t m_size = 0;
+
+		static size_t hash(const key_t* key) {
+			// heap pointers are aligned, so the low bits carry no information
+			uint64_t h = uint64_t(reinterpret_cast<uintptr_t>(key)) >> 4;
+			h *= 0x9E3779B97F4A7C15ull;
+			return size_t(h ^ (h >> 32));
+		}
+
+		void rehash(size_t capacity) {
+			std::vector<std::pair<const key_t*, value_t> > old_slots;
+			old_slots.swap(m_slots);
+			m_slots.assign(capacity, std::make_pair((const key_t*)nullptr, value_t()));
+			m_mask = capacity - 1;
+			m_size = 0;
+			for( auto& slot : old_slots ) {
+				if( slot.first ) {
+					insert(slot.first, slot.second);
+				}
+			}
+		}
+
+	public:
+		pointer_map() {}
+
+		explicit pointer_map(size_t expected_size) {
+			reserve(expected_size);
+		}
+
+		void reserve(size_t expected_size) {
+			size_t capacity = 16;
+			while( capacity < expected_size * 2 ) {
+				capacity *= 2;
+			}
+			if( capacity > m_slots.size() ) {
+				rehash(capacity);
+			}
+		}
+
+		size_t size() const { return m_size; }
+
+		// inserts or overwrites the value of key
+		void insert(const key_t* key, const value_t& value) {
+			if( (m_size + 1) * 2 > m_slots.size() ) {
+				rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+			}
+			size_t i = hash(key) & m_mask;
+			while( m_slots[i].first && m_slots[i].first != key ) {
+				i = (i + 1) & m_mask;
+			}
+			if( !m_slots[i].first ) {
+				m_slots[i].first = key;
+				++m_size;
+			}
+			m_slots[i].second = value;
+		}
+
+		// returns nullptr if key is not in the map
+		const value_t* find(const key_t* key) const {
+			if( m_slots.empty() || !key ) {
+				return nullptr;
+			}
+			size_t i = hash(key) & m_mask;
+			while( m_slots[i].first ) {
+				if( m_slots[i].first == key ) {
+					return &m_slots[i].second;
+				}
+				i = (i + 1) & m_mask;
+			}
+			return nullptr;
+		}
+	};
+}  // namespace carve
@@ -0,0 +1,93 @@
+// Copyright 2006-2015 Tobias Sargeant (tobias.sargeant@gmail.com).
+//
+// This file is part of the Carve CSG Library (http://carve-csg.com/)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+#include <carve/shewchuk_predicates.hpp>
+
+namespace carve {
+	namespace robust {
+
+		// Filtered orientation predicates. The determinant is evaluated in
+		// double precision together with a bound of its rounding error
+		// (Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast
+		// Robust Geometric Predicates"). Only if the sign is not certain
+		// within that interval, the adaptive exact evaluation is used. The
+		// sign of the result is always exact, the magnitude is that of the
+		// double precision determinant if the filter succeeds.
+
+		static constexpr double kRoundoff = std::numeric_limits<double>::epsilon() * 0.5;
+		static constexpr double kOrient2dErrBound = (3.0 + 16.0 * kRoundoff) * kRoundoff;
+		static constexpr double kOrient3dErrBound = (7.0 + 56.0 * kRoundoff) * kRoundoff;
+
+		/**
+		 * \brief Orientation of c with respect to the line a->b.
+		 *
+		 * @return positive if c is left of a->b, negative if right, zero if collinear.
+		 */
+		inline double orient2d(const double* pa, const double* pb, const double* pc) {
+			const double detleft = (pa[0] - pc[0]) * (pb[1] - pc[1]);
+			const double detright = (pa[1] - pc[1]) * (pb[0] - pc[0]);
+			const double det = detleft - detright;
+			const double errbound = kOrient2dErrBound * (std::fabs(detleft) + std::fabs(detright));
+			if( det > errbound || -det > errbound ) {
+				return det;
+			}
+			return shewchuk::orient2d(pa, pb, pc);
+		}
+
+		/**
+		 * \brief Orientation of d with respect to the plane through a, b, c.
+		 *
+		 * @return positive if d is below the plane (a, b, c appear anticlockwise
+		 *         seen from d), negative if above, zero if coplanar.
+		 */
+		inline double orient3d(const double* pa, const double* pb, const double* pc, const double* pd) {
+			const double adx = pa[0] - pd[0], bdx = pb[0] - pd[0], cdx = pc[0] - pd[0];
+			const double ady = pa[1] - pd[1], bdy = pb[1] - pd[1], cdy = pc[1] - pd[1];
+			const double adz = pa[2] - pd[2], bdz = pb[2] - pd[2], cdz = pc[2] - pd[2];
+
+			const double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+			const double cdxady = cdx * ady, adxcdy = adx * cdy;
+			const double adxbdy = adx * bdy, bdxady = bdx * ady;
+
+			const double det = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+			const double permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * std::fabs(adz)
+				+ (std::fabs(cdxady) + std::fabs(adxcdy)) * std::fabs(bdz)
+				+ (std::fabs(adxbdy) + std::fabs(bdxady)) * std::fabs(cdz);
+			const double errbound = kOrient3dErrBound * permanent;
+			if( det > errbound || -det > errbound ) {
+				return det;
+			}
+			return shewchuk::orient3d(pa, pb, pc, pd);
+		}
+
+		inline int sign(double value) {
+			return (value > 0.0) - (value < 0.0);
+		}
+	}  // namespace robust
+}  // namespace carve
@@ -142,6 +142,23 @@ namespace carve {
 				}
 			}
 
+			// recompute the bounding box extents of all nodes from their data, keeping the
+			// tree structure. Used when the data has moved, but the set of data is unchanged.
+			void refit() {
+				if (child) {
+					node_t* node = child;
+					node->refit();
+					bbox = node->bbox;
+					for (node = node->sibling; node; node = node->sibling) {
+						node->refit();
+						bbox.unionAABB(node->bbox);
+					}
+				}
+				else {
+					bbox.fit(data.begin(), data.end());
+				}
+			}
+
 			// update the bounding box extents of nodes that intersect obj (generally an aabb).
 			// The aabb class must provide a method intersects(obj_t).
 			bool remove(const data_t& val, const aabb_t& val_aabb, double eps)
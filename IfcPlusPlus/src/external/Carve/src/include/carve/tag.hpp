@@ -24,80 +24,68 @@
 
 #pragma once
 
+#include <atomic>
 #include <carve/carve.hpp>
-#ifdef _OPENMP
-#include <omp.h>
-#include <iostream>
-#endif
 
 namespace carve {
+	// tagable: visited marks for traversals. tag_begin() draws a new generation from a global counter and keeps it in a thread_local,
+	// so traversals in parallel threads do not interfere, as long as they do not visit the same objects at the same time.
 	class tagable {
 	private:
-		static int s_count[48];
+		static std::atomic<int> s_generation;
+		static inline thread_local int s_count = 1;
 
 	protected:
+		// 0 is never used as a generation, so new and untagged objects are not tagged in any traversal
 		mutable int __tag;
 
-		static inline int getCurrentThreadNum()
-		{
-			int threadNr = 0;
-#ifdef _OPENMP
-			threadNr = omp_get_thread_num();
-#endif
-			return threadNr;
-		}
-
 	public:
-		tagable(const tagable&)
+		tagable(const tagable&) : __tag(0)
 		{
-			int threadNr = getCurrentThreadNum();
-			__tag = s_count[threadNr] - 1;
 		}
 		tagable& operator=(const tagable&)
 		{
 			return *this;
 		}
 
-		tagable()
+		tagable() : __tag(0)
 		{
-			int threadNr = getCurrentThreadNum();
-			__tag = s_count[threadNr] - 1;
 		}
 
 		void tag() const
 		{
-			int threadNr = getCurrentThreadNum();
-			__tag = s_count[threadNr];
+			__tag = s_count;
 		}
 
 		void untag() const
 		{
-			int threadNr = getCurrentThreadNum();
-			__tag = s_count[threadNr] - 1;
+			__tag = 0;
 		}
 
 		bool is_tagged() const
 		{
-			int threadNr = getCurrentThreadNum();
-			return __tag == s_count[threadNr];
+			return __tag == s_count;
 		}
 
 		bool tag_once() const
 		{
-			int threadNr = getCurrentThreadNum();
-
-			if( __tag == s_count[threadNr] )
+			if( __tag == s_count )
 			{
 				return false;
 			}
-			__tag = s_count[threadNr];
+			__tag = s_count;
 			return true;
 		}
 
 		static void tag_begin()
 		{
-			int threadNr = getCurrentThreadNum();
-			s_count[threadNr]++;
+			int generation = s_generation.fetch_add(1, std::memory_order_relaxed) + 1;
+			if( generation == 0 )
+			{
+				// after wrap-around
+				generation = s_generation.fetch_add(1, std::memory_order_relaxed) + 1;
+			}
+			s_count = generation;
 		}
 	};
 }  // namespace carve
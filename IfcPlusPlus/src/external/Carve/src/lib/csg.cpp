@@ -79,7 +79,7 @@ void carve::csg::detail::LoopEdges::addFaceLoop(FaceLoop* fl) {
 
 void carve::csg::detail::LoopEdges::sortFaceLoopLists() {
   for (super::iterator i = begin(), e = end(); i != e; ++i) {
-    (*i).second.sort();
+    std::sort((*i).second.begin(), (*i).second.end());
   }
 }
 
@@ -90,7 +90,9 @@ void carve::csg::detail::LoopEdges::removeFaceLoop(FaceLoop* fl) {
     v2 = fl->vertices[j];
     iterator l(find(std::make_pair(v1, v2)));
     if (l != end()) {
-      (*l).second.remove(fl);
+      (*l).second.erase(
+          std::remove((*l).second.begin(), (*l).second.end(), fl),
+          (*l).second.end());
       if (!(*l).second.size()) {
         erase(l);
       }
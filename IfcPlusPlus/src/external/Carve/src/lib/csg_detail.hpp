@@ -25,6 +25,7 @@
 #pragma once
 
 #include <carve/carve.hpp>
+#include <carve/flat_hash_map.hpp>
 
 #include <carve/polyhedron_base.hpp>
 
@@ -62,9 +63,11 @@ typedef std::unordered_map<carve::mesh::Vertex<3>*,
                            std::vector<carve::mesh::MeshSet<3>::edge_t*> >
     VEVecMap;
 
+// face loops incident to each directed edge. Filled once per CSG operation
+// and then only queried, so a flat map is used.
 class LoopEdges
-    : public std::unordered_map<V2, std::list<FaceLoop*>, hash_pair> {
-  typedef std::unordered_map<V2, std::list<FaceLoop*>, hash_pair> super;
+    : public carve::flat_hash_map<V2, std::vector<FaceLoop*>, hash_pair> {
+  typedef carve::flat_hash_map<V2, std::vector<FaceLoop*>, hash_pair> super;
 
  public:
   void addFaceLoop(FaceLoop* fl);
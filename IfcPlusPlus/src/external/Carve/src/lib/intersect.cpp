@@ -35,6 +35,7 @@
 #include <set>
 
 #include <algorithm>
+#include <exception>
 
 #include "csg_data.hpp"
 #include "csg_detail.hpp"
@@ -636,7 +637,7 @@ void carve::csg::CSG::intersectingFacePairs(detail::Data& data)
 	}
 }
 
-void carve::csg::CSG::_generateVertexVertexIntersections(meshset_t::vertex_t* va, meshset_t::edge_t* eb)
+void carve::csg::CSG::_generateVertexVertexIntersections(meshset_t::vertex_t* va, meshset_t::edge_t* eb, deferred_t<meshset_t::vertex_t>* deferred)
 {
 	if( intersections.intersects(va, eb->v1()) ) {
 		return;
@@ -646,12 +647,16 @@ void carve::csg::CSG::_generateVertexVertexIntersections(meshset_t::vertex_t* va
 
 	if( d_v1 < m_epsilon * m_epsilon )
 	{
+		if( deferred ) {
+			deferred->push_back(std::make_pair(va, eb));
+			return;
+		}
 		intersections.record(va, eb->v1(), va);
 	}
 }
 
 void carve::csg::CSG::generateVertexVertexIntersections(
-	meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b) {
+	meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b, deferred_t<meshset_t::vertex_t>* deferred) {
 	meshset_t::edge_t* ea, * eb;
 
 	ea = a->edge;
@@ -660,7 +665,7 @@ void carve::csg::CSG::generateVertexVertexIntersections(
 			meshset_t::face_t* t = b[i];
 			eb = t->edge;
 			do {
-				_generateVertexVertexIntersections(ea->v1(), eb);
+				_generateVertexVertexIntersections(ea->v1(), eb, deferred);
 				eb = eb->next;
 			} while( eb != t->edge );
 		}
@@ -668,7 +673,7 @@ void carve::csg::CSG::generateVertexVertexIntersections(
 	} while( ea != a->edge );
 }
 
-void carve::csg::CSG::_generateVertexEdgeIntersections(meshset_t::vertex_t* va, meshset_t::edge_t* eb) {
+void carve::csg::CSG::_generateVertexEdgeIntersections(meshset_t::vertex_t* va, meshset_t::edge_t* eb, deferred_t<meshset_t::vertex_t>* deferred) {
 	if( intersections.intersects(va, eb) ) {
 		return;
 	}
@@ -684,6 +689,10 @@ void carve::csg::CSG::_generateVertexEdgeIntersections(meshset_t::vertex_t* va,
 
 	if( a < b * m_epsilon*m_epsilon ) {
 		// vertex-edge intersection
+		if( deferred ) {
+			deferred->push_back(std::make_pair(va, eb));
+			return;
+		}
 		intersections.record(eb, va, va);
 		if( eb->rev ) {
 			intersections.record(eb->rev, va, va);
@@ -692,7 +701,7 @@ void carve::csg::CSG::_generateVertexEdgeIntersections(meshset_t::vertex_t* va,
 }
 
 void carve::csg::CSG::generateVertexEdgeIntersections(
-	meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b) {
+	meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b, deferred_t<meshset_t::vertex_t>* deferred) {
 	meshset_t::edge_t* ea, * eb;
 
 	ea = a->edge;
@@ -701,7 +710,7 @@ void carve::csg::CSG::generateVertexEdgeIntersections(
 			meshset_t::face_t* t = b[i];
 			eb = t->edge;
 			do {
-				_generateVertexEdgeIntersections(ea->v1(), eb);
+				_generateVertexEdgeIntersections(ea->v1(), eb, deferred);
 				eb = eb->next;
 			} while( eb != t->edge );
 		}
@@ -709,7 +718,7 @@ void carve::csg::CSG::generateVertexEdgeIntersections(
 	} while( ea != a->edge );
 }
 
-void carve::csg::CSG::_generateEdgeEdgeIntersections(meshset_t::edge_t* ea, meshset_t::edge_t* eb)
+void carve::csg::CSG::_generateEdgeEdgeIntersections(meshset_t::edge_t* ea, meshset_t::edge_t* eb, deferred_t<meshset_t::edge_t>* deferred)
 {
 	if( intersections.intersects(ea, eb) ) {
 		return;
@@ -744,6 +753,10 @@ void carve::csg::CSG::_generateEdgeEdgeIntersections(meshset_t::edge_t* ea, mesh
 	case carve::RR_INTERSECTION: {
 		// edges intersect
 		if( mu1 >= 0.0 && mu1 <= 1.0 && mu2 >= 0.0 && mu2 <= 1.0 ) {
+			if( deferred ) {
+				deferred->push_back(std::make_pair(ea, eb));
+				break;
+			}
 			meshset_t::vertex_t* p = vertex_pool.get((p1 + p2) / 2.0);
 			intersections.record(ea, eb, p);
 			if( ea->rev ) {
@@ -764,6 +777,11 @@ void carve::csg::CSG::_generateEdgeEdgeIntersections(meshset_t::edge_t* ea, mesh
 		break;
 	}
 	case carve::RR_DEGENERATE: {
+		if( deferred ) {
+			// thrown when the pair is recorded
+			deferred->push_back(std::make_pair(ea, eb));
+			break;
+		}
 		throw carve::exception("degenerate edge");
 		break;
 	}
@@ -773,7 +791,7 @@ void carve::csg::CSG::_generateEdgeEdgeIntersections(meshset_t::edge_t* ea, mesh
 	}
 }
 
-void carve::csg::CSG::generateEdgeEdgeIntersections( meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b)
+void carve::csg::CSG::generateEdgeEdgeIntersections( meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b, deferred_t<meshset_t::edge_t>* deferred)
 {
 	meshset_t::edge_t* ea, * eb;
 
@@ -783,7 +801,7 @@ void carve::csg::CSG::generateEdgeEdgeIntersections( meshset_t::face_t* a, const
 			meshset_t::face_t* t = b[i];
 			eb = t->edge;
 			do {
-				_generateEdgeEdgeIntersections(ea, eb);
+				_generateEdgeEdgeIntersections(ea, eb, deferred);
 				eb = eb->next;
 			} while( eb != t->edge );
 		}
@@ -791,7 +809,7 @@ void carve::csg::CSG::generateEdgeEdgeIntersections( meshset_t::face_t* a, const
 	} while( ea != a->edge );
 }
 
-void carve::csg::CSG::_generateVertexFaceIntersections(meshset_t::face_t* fa, meshset_t::edge_t* eb)
+void carve::csg::CSG::_generateVertexFaceIntersections(meshset_t::face_t* fa, meshset_t::edge_t* eb, deferred_t<meshset_t::face_t>* deferred)
 {
 	if( intersections.intersects(eb->v1(), fa) )
 	{
@@ -802,25 +820,29 @@ void carve::csg::CSG::_generateVertexFaceIntersections(meshset_t::face_t* fa, me
 
 	if( fabs(d1) < m_epsilon && fa->containsPoint(eb->v1()->v, m_epsilon) )
 	{
+		if( deferred ) {
+			deferred->push_back(std::make_pair(fa, eb));
+			return;
+		}
 		intersections.record(eb->v1(), fa, eb->v1());
 	}
 }
 
 void carve::csg::CSG::generateVertexFaceIntersections(
-	meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b) {
+	meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b, deferred_t<meshset_t::face_t>* deferred) {
 	meshset_t::edge_t* eb;
 
 	for( size_t i = 0; i < b.size(); ++i ) {
 		meshset_t::face_t* t = b[i];
 		eb = t->edge;
 		do {
-			_generateVertexFaceIntersections(a, eb);
+			_generateVertexFaceIntersections(a, eb, deferred);
 			eb = eb->next;
 		} while( eb != t->edge );
 	}
 }
 
-void carve::csg::CSG::_generateEdgeFaceIntersections(meshset_t::face_t* fa, meshset_t::edge_t* eb)
+void carve::csg::CSG::_generateEdgeFaceIntersections(meshset_t::face_t* fa, meshset_t::edge_t* eb, deferred_t<meshset_t::face_t>* deferred)
 {
 	if( intersections.intersects(eb, fa) )
 	{
@@ -830,6 +852,10 @@ void carve::csg::CSG::_generateEdgeFaceIntersections(meshset_t::face_t* fa, mesh
 	meshset_t::vertex_t::vector_t _p;
 	if( fa->simpleLineSegmentIntersection( carve::geom3d::LineSegment(eb->v1()->v, eb->v2()->v), _p, m_epsilon) )
 	{
+		if( deferred ) {
+			deferred->push_back(std::make_pair(fa, eb));
+			return;
+		}
 		meshset_t::vertex_t* p = vertex_pool.get(_p);
 		intersections.record(eb, fa, p);
 		if( eb->rev ) {
@@ -838,7 +864,7 @@ void carve::csg::CSG::_generateEdgeFaceIntersections(meshset_t::face_t* fa, mesh
 	}
 }
 
-void carve::csg::CSG::generateEdgeFaceIntersections( meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b)
+void carve::csg::CSG::generateEdgeFaceIntersections( meshset_t::face_t* a, const std::vector<meshset_t::face_t*>& b, deferred_t<meshset_t::face_t>* deferred)
 {
 	meshset_t::edge_t* eb;
 
@@ -847,7 +873,7 @@ void carve::csg::CSG::generateEdgeFaceIntersections( meshset_t::face_t* a, const
 		meshset_t::face_t* t = b[i];
 		eb = t->edge;
 		do {
-			_generateEdgeFaceIntersections(a, eb);
+			_generateEdgeFaceIntersections(a, eb, deferred);
 			eb = eb->next;
 		} while( eb != t->edge );
 	}
@@ -921,46 +947,83 @@ void carve::csg::CSG::generateIntersectionCandidates( meshset_t* a, const face_r
 	}
 }
 
-void carve::csg::CSG::generateIntersections(meshset_t* a, const face_rtree_t* a_rtree, meshset_t* b, const face_rtree_t* b_rtree, detail::Data& data)
+template <typename obj_t>
+void carve::csg::CSG::generateIntersectionsPass(
+	const std::vector<const face_pairs_t::value_type*>& face_pairs,
+	void (CSG::*generate_face)(meshset_t::face_t*, const std::vector<meshset_t::face_t*>&, deferred_t<obj_t>*),
+	void (CSG::*generate)(obj_t*, meshset_t::edge_t*, deferred_t<obj_t>*))
 {
-	face_pairs_t face_pairs;
-	generateIntersectionCandidates(a, a_rtree, b, b_rtree, face_pairs);
+	// below this, the overhead of distributing the work is larger than the gain
+	const size_t min_parallel_pairs = 256;
+	const size_t chunk_size = 32;
 
-	for( face_pairs_t::const_iterator i = face_pairs.begin(); i != face_pairs.end(); ++i )
+	if( !parallel_for || face_pairs.size() < min_parallel_pairs )
 	{
-		meshset_t::face_t* f = (*i).first;
-		meshset_t::edge_t* e = f->edge;
-		do {
-			data.vert_to_edges[e->v1()].push_back(e);
-			e = e->next;
-		} while( e != f->edge );
+		for( size_t i = 0; i < face_pairs.size(); ++i )
+		{
+			(this->*generate_face)(face_pairs[i]->first, face_pairs[i]->second, nullptr);
+		}
+		return;
 	}
 
-	for( face_pairs_t::const_iterator i = face_pairs.begin(); i != face_pairs.end(); ++i )
-	{
-		generateVertexVertexIntersections((*i).first, (*i).second);
-	}
+	// the chunks only read intersections, which holds the results of the previous passes
+	const size_t n_chunks = (face_pairs.size() + chunk_size - 1) / chunk_size;
+	std::vector<deferred_t<obj_t> > deferred(n_chunks);
+	std::vector<std::exception_ptr> errors(n_chunks);
+	parallel_for(n_chunks, [&](size_t chunk) {
+		try {
+			const size_t end = std::min(face_pairs.size(), (chunk + 1) * chunk_size);
+			for( size_t i = chunk * chunk_size; i < end; ++i )
+			{
+				(this->*generate_face)(face_pairs[i]->first, face_pairs[i]->second, &deferred[chunk]);
+			}
+		} catch( ... ) {
+			errors[chunk] = std::current_exception();
+		}
+	});
 
-	for( face_pairs_t::const_iterator i = face_pairs.begin(); i != face_pairs.end(); ++i )
+	for( size_t chunk = 0; chunk < n_chunks; ++chunk )
 	{
-		generateVertexEdgeIntersections((*i).first, (*i).second);
+		if( errors[chunk] ) {
+			std::rethrow_exception(errors[chunk]);
+		}
 	}
 
-	for( face_pairs_t::const_iterator i = face_pairs.begin(); i != face_pairs.end(); ++i )
+	// Record in the order of the serial pass. The test is repeated, because a
+	// pair may intersect only through an intersection recorded in this pass.
+	for( size_t chunk = 0; chunk < n_chunks; ++chunk )
 	{
-		generateEdgeEdgeIntersections((*i).first, (*i).second);
+		for( size_t i = 0; i < deferred[chunk].size(); ++i )
+		{
+			(this->*generate)(deferred[chunk][i].first, deferred[chunk][i].second, nullptr);
+		}
 	}
+}
 
-	for( face_pairs_t::const_iterator i = face_pairs.begin(); i != face_pairs.end(); ++i )
-	{
-		generateVertexFaceIntersections((*i).first, (*i).second);
-	}
+void carve::csg::CSG::generateIntersections(meshset_t* a, const face_rtree_t* a_rtree, meshset_t* b, const face_rtree_t* b_rtree, detail::Data& data)
+{
+	face_pairs_t face_pairs;
+	generateIntersectionCandidates(a, a_rtree, b, b_rtree, face_pairs);
 
+	std::vector<const face_pairs_t::value_type*> face_pair_list;
+	face_pair_list.reserve(face_pairs.size());
 	for( face_pairs_t::const_iterator i = face_pairs.begin(); i != face_pairs.end(); ++i )
 	{
-		generateEdgeFaceIntersections((*i).first, (*i).second);
+		meshset_t::face_t* f = (*i).first;
+		meshset_t::edge_t* e = f->edge;
+		do {
+			data.vert_to_edges[e->v1()].push_back(e);
+			e = e->next;
+		} while( e != f->edge );
+		face_pair_list.push_back(&(*i));
 	}
 
+	generateIntersectionsPass<meshset_t::vertex_t>(face_pair_list, &CSG::generateVertexVertexIntersections, &CSG::_generateVertexVertexIntersections);
+	generateIntersectionsPass<meshset_t::vertex_t>(face_pair_list, &CSG::generateVertexEdgeIntersections, &CSG::_generateVertexEdgeIntersections);
+	generateIntersectionsPass<meshset_t::edge_t>(face_pair_list, &CSG::generateEdgeEdgeIntersections, &CSG::_generateEdgeEdgeIntersections);
+	generateIntersectionsPass<meshset_t::face_t>(face_pair_list, &CSG::generateVertexFaceIntersections, &CSG::_generateVertexFaceIntersections);
+	generateIntersectionsPass<meshset_t::face_t>(face_pair_list, &CSG::generateEdgeFaceIntersections, &CSG::_generateEdgeFaceIntersections);
+
 #if defined(CARVE_DEBUG)
 	std::cerr << "makeVertexIntersections" << std::endl;
 #endif
@@ -1440,13 +1503,13 @@ carve::mesh::MeshSet<3>* carve::csg::CSG::compute( meshset_t* a, meshset_t* b, c
 	size_t a_edge_count;
 	size_t b_edge_count;
 
-	std::unique_ptr<face_rtree_t> a_rtree( face_rtree_t::construct_STR(a->faceBegin(), a->faceEnd(), 4, 4));
-	std::unique_ptr<face_rtree_t> b_rtree( face_rtree_t::construct_STR(b->faceBegin(), b->faceEnd(), 4, 4));
+	const face_rtree_t* a_rtree = a->faceTree();
+	const face_rtree_t* b_rtree = b->faceTree();
 
 	{
 		static carve::TimingName FUNC_NAME("CSG::compute - calc()");
 		carve::TimingBlock block(FUNC_NAME);
-		calc(a, a_rtree.get(), b, b_rtree.get(), vclass, eclass, a_face_loops, b_face_loops, a_edge_count, b_edge_count);
+		calc(a, a_rtree, b, b_rtree, vclass, eclass, a_face_loops, b_face_loops, a_edge_count, b_edge_count);
 	}
 
 	detail::LoopEdges a_edge_map;
@@ -1521,10 +1584,10 @@ carve::mesh::MeshSet<3>* carve::csg::CSG::compute( meshset_t* a, meshset_t* b, c
 	switch( classify_type )
 	{
 	case CLASSIFY_EDGE:
-		classifyFaceGroupsEdge(shared_edges, vclass, a, a_rtree.get(), a_loops_grouped, a_edge_map, b, b_rtree.get(), b_loops_grouped, b_edge_map, collector);
+		classifyFaceGroupsEdge(shared_edges, vclass, a, a_rtree, a_loops_grouped, a_edge_map, b, b_rtree, b_loops_grouped, b_edge_map, collector);
 		break;
 	case CLASSIFY_NORMAL:
-		classifyFaceGroups(shared_edges, vclass, a, a_rtree.get(), a_loops_grouped, a_edge_map, b, b_rtree.get(), b_loops_grouped, b_edge_map, collector);
+		classifyFaceGroups(shared_edges, vclass, a, a_rtree, a_loops_grouped, a_edge_map, b, b_rtree, b_loops_grouped, b_edge_map, collector);
 		break;
 	}
 
@@ -1665,10 +1728,10 @@ bool carve::csg::CSG::sliceAndClassify( meshset_t* closed, meshset_t* open, std:
 	size_t a_edge_count;
 	size_t b_edge_count;
 
-	std::unique_ptr<face_rtree_t> closed_rtree(face_rtree_t::construct_STR( closed->faceBegin(), closed->faceEnd(), 4, 4));
-	std::unique_ptr<face_rtree_t> open_rtree( face_rtree_t::construct_STR(open->faceBegin(), open->faceEnd(), 4, 4));
+	const face_rtree_t* closed_rtree = closed->faceTree();
+	const face_rtree_t* open_rtree = open->faceTree();
 
-	calc(closed, closed_rtree.get(), open, open_rtree.get(), vclass, eclass, a_face_loops, b_face_loops, a_edge_count, b_edge_count);
+	calc(closed, closed_rtree, open, open_rtree, vclass, eclass, a_face_loops, b_face_loops, a_edge_count, b_edge_count);
 
 	detail::LoopEdges a_edge_map;
 	detail::LoopEdges b_edge_map;
@@ -1683,7 +1746,7 @@ bool carve::csg::CSG::sliceAndClassify( meshset_t* closed, meshset_t* open, std:
 	groupFaceLoops(closed, a_face_loops, a_edge_map, shared_edges, a_loops_grouped);
 	groupFaceLoops(open, b_face_loops, b_edge_map, shared_edges, b_loops_grouped);
 
-	halfClassifyFaceGroups(shared_edges, vclass, closed, closed_rtree.get(), a_loops_grouped, a_edge_map, open, open_rtree.get(), b_loops_grouped, b_edge_map, result);
+	halfClassifyFaceGroups(shared_edges, vclass, closed, closed_rtree, a_loops_grouped, a_edge_map, open, open_rtree, b_loops_grouped, b_edge_map, result);
 
 	if( shared_edges_ptr != nullptr )
 	{
@@ -1721,10 +1784,10 @@ void carve::csg::CSG::slice(meshset_t* a, meshset_t* b, std::list<meshset_t*>& a
 	size_t a_edge_count;
 	size_t b_edge_count;
 
-	std::unique_ptr<face_rtree_t> a_rtree( face_rtree_t::construct_STR(a->faceBegin(), a->faceEnd(), 4, 4));
-	std::unique_ptr<face_rtree_t> b_rtree( face_rtree_t::construct_STR(b->faceBegin(), b->faceEnd(), 4, 4));
+	const face_rtree_t* a_rtree = a->faceTree();
+	const face_rtree_t* b_rtree = b->faceTree();
 
-	calc(a, a_rtree.get(), b, b_rtree.get(), vclass, eclass, a_face_loops, b_face_loops, a_edge_count, b_edge_count);
+	calc(a, a_rtree, b, b_rtree, vclass, eclass, a_face_loops, b_face_loops, a_edge_count, b_edge_count);
 
 	detail::LoopEdges a_edge_map;
 	detail::LoopEdges b_edge_map;
@@ -39,6 +39,7 @@
 #include <set>
 
 #include <algorithm>
+#include <cmath>
 
 #include "csg_detail.hpp"
 
@@ -223,7 +224,8 @@ namespace carve {
 				}
 			}
 
-			static void classifyAB(const GrpEdgeSurfMap& a_edge_surfaces, const GrpEdgeSurfMap& b_edge_surfaces, Classification& classifications)
+			// Surfaces count as coincident if their angles around the edge differ by less than angle_epsilon (radians)
+			static void classifyAB(const GrpEdgeSurfMap& a_edge_surfaces, const GrpEdgeSurfMap& b_edge_surfaces, Classification& classifications, double angle_epsilon)
 			{
 				// two faces in the a surface
 				for( GrpEdgeSurfMap::const_iterator ib = b_edge_surfaces.begin(),
@@ -249,11 +251,11 @@ namespace carve {
 								FaceClass fc;
 
 								if( fabs((*ib).second.fwd_ang - (*ia).second.fwd_ang) <
-									ANGLE_EPSILON ) {
+									angle_epsilon ) {
 									fc = FACE_ON_ORIENT_OUT;
 								}
 								else if( fabs((*ib).second.fwd_ang - (*ia).second.rev_ang) <
-									ANGLE_EPSILON ) {
+									angle_epsilon ) {
 									fc = FACE_ON_ORIENT_IN;
 								}
 								else {
@@ -301,11 +303,11 @@ namespace carve {
 								FaceClass fc;
 
 								if( fabs((*ib).second.rev_ang - (*ia).second.fwd_ang) <
-									ANGLE_EPSILON ) {
+									angle_epsilon ) {
 									fc = FACE_ON_ORIENT_IN;
 								}
 								else if( fabs((*ib).second.rev_ang - (*ia).second.rev_ang) <
-									ANGLE_EPSILON ) {
+									angle_epsilon ) {
 									fc = FACE_ON_ORIENT_OUT;
 								}
 								else {
@@ -335,9 +337,9 @@ namespace carve {
 				}
 			}
 
-			static bool processForwardEdgeSurfaces( GrpEdgeSurfMap& edge_surfaces, const std::list<FaceLoop*>& fwd, const carve::geom3d::Vector& edge_vector, const carve::geom3d::Vector& base_vector, double CARVE_EPSILON)
+			static bool processForwardEdgeSurfaces( GrpEdgeSurfMap& edge_surfaces, const std::vector<FaceLoop*>& fwd, const carve::geom3d::Vector& edge_vector, const carve::geom3d::Vector& base_vector, double CARVE_EPSILON)
 			{
-				for( std::list<FaceLoop*>::const_iterator i = fwd.begin(), e = fwd.end();
+				for( std::vector<FaceLoop*>::const_iterator i = fwd.begin(), e = fwd.end();
 					i != e; ++i ) {
 					EdgeSurface& es = (edge_surfaces[(*i)->orig_face->mesh]);
 					if( es.fwd != nullptr ) {
@@ -349,9 +351,9 @@ namespace carve {
 				return true;
 			}
 
-			static bool processReverseEdgeSurfaces( GrpEdgeSurfMap& edge_surfaces, const std::list<FaceLoop*>& rev, const carve::geom3d::Vector& edge_vector, const carve::geom3d::Vector& base_vector, double CARVE_EPSILON)
+			static bool processReverseEdgeSurfaces( GrpEdgeSurfMap& edge_surfaces, const std::vector<FaceLoop*>& rev, const carve::geom3d::Vector& edge_vector, const carve::geom3d::Vector& base_vector, double CARVE_EPSILON)
 			{
-				for( std::list<FaceLoop*>::const_iterator i = rev.begin(), e = rev.end();
+				for( std::vector<FaceLoop*>::const_iterator i = rev.begin(), e = rev.end();
 					i != e; ++i ) {
 					EdgeSurface& es = (edge_surfaces[(*i)->orig_face->mesh]);
 					if( es.rev != nullptr ) {
@@ -400,8 +402,11 @@ namespace carve {
 					return;
 				}
 
-				classifyAB(a_edge_surfaces, b_edge_surfaces, b_classification);
-				classifyAB(b_edge_surfaces, a_edge_surfaces, a_classification);
+				// antiClockwiseAngle() and facesAreCoplanar() treat unit normals as parallel if their cross product, the sine of the
+				// angle between them, is below CARVE_EPSILON. Faces at a smaller angle must not be classified as crossing here.
+				const double angle_epsilon = std::max(ANGLE_EPSILON, asin(std::min(CARVE_EPSILON, 1.0)));
+				classifyAB(a_edge_surfaces, b_edge_surfaces, b_classification, angle_epsilon);
+				classifyAB(b_edge_surfaces, a_edge_surfaces, a_classification, angle_epsilon);
 			}
 
 			static void traceIntersectionGraph(
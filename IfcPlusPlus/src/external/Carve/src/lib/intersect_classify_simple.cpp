@@ -244,7 +244,7 @@ static void classifySimpleOnFaces(FaceLoopList &a_face_loops,
     LoopEdges::const_iterator t;
     t = edge_map.find(std::make_pair(i->vertices[0], i->vertices[1]));
     if (t != edge_map.end()) {
-      for (std::list<FaceLoop *>::const_iterator
+      for (std::vector<FaceLoop *>::const_iterator
              u = (*t).second.begin(), ue = (*t).second.end(); u != ue; ++u) {
         FaceLoop *j(*u);
         int k = is_same(i->vertices, j->vertices);
@@ -269,7 +269,7 @@ static void classifySimpleOnFaces(FaceLoopList &a_face_loops,
     }
     t = edge_map.find(std::make_pair(i->vertices[1], i->vertices[0]));
     if (t != edge_map.end()) {
-      for (std::list<FaceLoop *>::const_iterator
+      for (std::vector<FaceLoop *>::const_iterator
              u = (*t).second.begin(), ue = (*t).second.end(); u != ue; ++u) {
         FaceLoop *j(*u);
         int k = is_same(i->vertices, j->vertices);
@@ -155,7 +155,8 @@ namespace {
 	};
 
 	struct Graph {
-		typedef std::unordered_map<carve::mesh::Vertex<3>*, GraphEdges>
+		// iterated in insertion order, so the choice of start edges does not depend on vertex addresses
+		typedef carve::flat_hash_map<carve::mesh::Vertex<3>*, GraphEdges>
 			graph_t;
 
 		graph_t graph;
@@ -35,9 +35,7 @@
 void carve::csg::CSG::makeEdgeMap(const carve::csg::FaceLoopList& loops,
                                   size_t edge_count,
                                   detail::LoopEdges& edge_map) {
-#if defined(UNORDERED_COLLECTIONS_SUPPORT_RESIZE)
-  edge_map.resize(edge_count);
-#endif
+  edge_map.reserve(edge_count);
 
   for (carve::csg::FaceLoop* i = loops.head; i; i = i->next) {
     edge_map.addFaceLoop(i);
@@ -203,7 +201,7 @@ void carve::csg::CSG::groupFaceLoops(
 
           j = loop_edges.find(std::make_pair(v1, v2));
           if (j != loop_edges.end()) {
-            for (std::list<carve::csg::FaceLoop *>::const_iterator
+            for (std::vector<carve::csg::FaceLoop *>::const_iterator
                      k = (*j).second.begin(),
                      ke = (*j).second.end();
                  k != ke; ++k) {
@@ -219,7 +217,7 @@ void carve::csg::CSG::groupFaceLoops(
 
           j = loop_edges.find(std::make_pair(v2, v1));
           if (j != loop_edges.end()) {
-            for (std::list<carve::csg::FaceLoop *>::const_iterator
+            for (std::vector<carve::csg::FaceLoop *>::const_iterator
                      k = (*j).second.begin(),
                      ke = (*j).second.end();
                  k != ke; ++k) {
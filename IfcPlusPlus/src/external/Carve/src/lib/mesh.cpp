@@ -453,8 +453,8 @@ namespace carve {
 				}
 			}
 
-			void FaceStitcher::buildEdgeGraph(const edge_map_t& all_edges) {
-				for( edge_map_t::const_iterator it = all_edges.begin(); it != all_edges.end(); ++it )
+			void FaceStitcher::buildEdgeGraph(const complex_edge_map_t& all_edges) {
+				for( complex_edge_map_t::const_iterator it = all_edges.begin(); it != all_edges.end(); ++it )
 				{
 					edge_graph[(*it).first.first].insert((*it).first.second);
 				}
@@ -491,7 +491,7 @@ namespace carve {
 				std::vector<const edge_t*> efwd;
 				std::vector<const edge_t*> erev;
 
-				edge_map_t::iterator edgeiter;
+				complex_edge_map_t::iterator edgeiter;
 				edgeiter = complex_edges.find(vpair_t(vert, next));
 				if( edgeiter == complex_edges.end() )
 				{
@@ -690,7 +690,7 @@ namespace carve {
 				{
 					std::list<vpair_t> edge_0, edge_1;
 
-					for( edge_map_t::iterator it = complex_edges.begin(); it != complex_edges.end(); ++it )
+					for( complex_edge_map_t::iterator it = complex_edges.begin(); it != complex_edges.end(); ++it )
 					{
 						bool was_modified = false;
 						for( edgelist_t::iterator j = (*it).second.begin(); j != (*it).second.end();)
@@ -717,12 +717,12 @@ namespace carve {
 					for( std::list<vpair_t>::iterator it = edge_1.begin(); it != edge_1.end(); ++it )
 					{
 						vpair_t e1 = *it;
-						edge_map_t::iterator e1i = complex_edges.find(e1);
+						complex_edge_map_t::iterator e1i = complex_edges.find(e1);
 						if( e1i == complex_edges.end() ) {
 							continue;
 						}
 						vpair_t e2 = vpair_t(e1.second, e1.first);
-						edge_map_t::iterator e2i = complex_edges.find(e2);
+						complex_edge_map_t::iterator e2i = complex_edges.find(e2);
 						if (e2i == complex_edges.end())
 						{
 							// each complex edge should have a mate.
@@ -768,14 +768,14 @@ namespace carve {
 					for( std::list<vpair_t>::iterator it = edge_0.begin(); it != edge_0.end(); ++it )
 					{
 						vpair_t e1 = *it;
-						edge_map_t::iterator e1i = complex_edges.find(e1);
+						complex_edge_map_t::iterator e1i = complex_edges.find(e1);
 						if( e1i == complex_edges.end() )
 						{
 							continue;
 						}
 
 						vpair_t e2 = vpair_t(e1.second, e1.first);
-						edge_map_t::iterator e2i = complex_edges.find(e2);
+						complex_edge_map_t::iterator e2i = complex_edges.find(e2);
 						if( e2i == complex_edges.end() ) {
 							// This could occur, for example, when two faces share an edge in the same direction, but are both not 
 							//  touching anything else. Both get removed by the open group removal code, leaving an edge map with zero
@@ -798,7 +798,7 @@ namespace carve {
 						complex_edges.erase(e1i);
 						if( eraseSecond )
 						{
-							edge_map_t::iterator e2i_check = complex_edges.find(e2);
+							complex_edge_map_t::iterator e2i_check = complex_edges.find(e2);
 							if( e2i_check != complex_edges.end() )
 
 								//if( e2i != complex_edges.end() )
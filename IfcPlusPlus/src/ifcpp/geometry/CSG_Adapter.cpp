@@ -18,6 +18,7 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 
 #include <ifcpp/geometry/GeometryException.h>
 #include <ifcpp/geometry/GeomDebugDump.h>
+#include <ifcpp/geometry/GeometryProfiler.h>
 #include <ifcpp/geometry/GeometrySettings.h>
 #include <ifcpp/model/BasicTypes.h>
 #include <ifcpp/model/BuildingException.h>
@@ -31,6 +32,7 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 #include "MeshOps.h"
 #include "MeshFlattener.h"
 #include "GeometryInputData.h"
+#include "TaskScheduler.h"
 
 #if defined(_DEBUG) || defined(_DEBUG_RELEASE)
 static int csg_compute_count = 0;
@@ -102,6 +104,22 @@ void CSG_Adapter::mergeMeshesToMeshset(std::vector<carve::mesh::Mesh<3>*>& meshe
 	}
 }
 
+void CSG_Adapter::setParallelFor(carve::csg::CSG& csg, const GeomProcessingParams& params)
+{
+	if (!params.generalSettings)
+	{
+		return;
+	}
+	shared_ptr<TaskScheduler> scheduler = params.generalSettings->m_task_scheduler;
+	if (scheduler && scheduler->getNumThreads() > 1)
+	{
+		csg.parallel_for = [scheduler](size_t numElements, const std::function<void(size_t)>& func)
+		{
+			scheduler->parallelFor(numElements, func);
+		};
+	}
+}
+
 void CSG_Adapter::assignResultOnFail(const shared_ptr<carve::mesh::MeshSet<3> >& op1, const shared_ptr<carve::mesh::MeshSet<3> >& op2, const carve::csg::CSG::OP operation, shared_ptr<carve::mesh::MeshSet<3> >& result)
 {
 	if (operation == carve::csg::CSG::A_MINUS_B)
@@ -150,9 +168,9 @@ bool CSG_Adapter::checkBoundingBoxIntersection(const carve::geom::aabb<3>& bbox1
 bool checkResultByBBoxAndVolume(const shared_ptr<carve::mesh::MeshSet<3> >& op1, const shared_ptr<carve::mesh::MeshSet<3> >& op2,
 	const shared_ptr<carve::mesh::MeshSet<3> >& result, GeomProcessingParams& paramsScaled, double epsDefault, double expectedMinVolume)
 {
-	carve::geom::aabb<3> bboxOperandA = op1->getAABB();
-	carve::geom::aabb<3> bboxOperandB = op2->getAABB();
-	carve::geom::aabb<3> bboxResult = result->getAABB();
+	carve::geom::aabb<3> bboxOperandA = MeshOps::computeMeshSetAABB(op1.get());
+	carve::geom::aabb<3> bboxOperandB = MeshOps::computeMeshSetAABB(op2.get());
+	carve::geom::aabb<3> bboxResult = MeshOps::computeMeshSetAABB(result.get());
 	bool resultBboxWrong = false;
 #ifdef CSG_DEBUG
 	if ((paramsScaled.debugDump || csg_compute_count > 14) && false)
@@ -232,9 +250,36 @@ bool checkResultByBBoxAndVolume(const shared_ptr<carve::mesh::MeshSet<3> >& op1,
 	return !resultBboxWrong;
 }
 
+static shared_ptr<carve::mesh::MeshSet<3> > getNormalizedOperand(const shared_ptr<carve::mesh::MeshSet<3> >& input, CarveMeshNormalizer& normMesh, const std::string& tag, double eps,
+	shared_ptr<carve::mesh::MeshSet<3> >* cachedOperand)
+{
+	if (cachedOperand && *cachedOperand)
+	{
+		return *cachedOperand;
+	}
+
+	shared_ptr<carve::mesh::MeshSet<3> > operand;
+	if (normMesh.isIdentity())
+	{
+		// nothing to normalize, the input is used directly, and copied only before it would be modified
+		operand = input;
+	}
+	else
+	{
+		operand = shared_ptr<carve::mesh::MeshSet<3> >(input->clone());
+		normMesh.normalizeMesh(operand, tag, eps);
+	}
+
+	if (cachedOperand)
+	{
+		*cachedOperand = operand;
+	}
+	return operand;
+}
+
 bool CSG_Adapter::computeCSG_Carve(const shared_ptr<carve::mesh::MeshSet<3> >& inputA, const shared_ptr<carve::mesh::MeshSet<3> >& inputB, 
 	const carve::csg::CSG::OP operation, shared_ptr<carve::mesh::MeshSet<3> >& result,
-	GeomProcessingParams& params, CsgOperationParams& csgParams)
+	GeomProcessingParams& params, CsgOperationParams& csgParams, NormalizedOperands* normalizedOperands)
 {
 	if (!inputA || !inputB)
 	{
@@ -327,18 +372,22 @@ bool CSG_Adapter::computeCSG_Carve(const shared_ptr<carve::mesh::MeshSet<3> >& i
 	MeshOps::checkMeshSetValidAndClosed(inputA, infoInputA, paramsScaled);
 	MeshOps::checkMeshSetValidAndClosed(inputB, infoInputB, paramsScaled);
 
-	shared_ptr<carve::mesh::MeshSet<3> > op1(inputA->clone());
-	shared_ptr<carve::mesh::MeshSet<3> > op2(inputB->clone());
+	shared_ptr<carve::mesh::MeshSet<3> > op1;
+	shared_ptr<carve::mesh::MeshSet<3> > op2;
 
 	std::stringstream strs_err;
 	try
 	{
-		// normalize first, so that EPS values match the size of different meshes
-		normMesh.normalizeMesh(op1, "op1", epsDefault);
-		normMesh.normalizeMesh(op2, "op2", epsDefault);
+		// normalize first, so that EPS values match the size of different meshes. The normalized operands are shared with other variants of this operation
+		const size_t normalizedIndex = csgParams.normalizeCoords ? 1 : 0;
+		op1 = getNormalizedOperand(inputA, normMesh, "op1", epsDefault, normalizedOperands ? &normalizedOperands->op1[normalizedIndex] : nullptr);
+		op2 = getNormalizedOperand(inputB, normMesh, "op2", epsDefault, normalizedOperands ? &normalizedOperands->op2[normalizedIndex] : nullptr);
 
 		if (csgParams.flattenFacePlanes )
 		{
+			// flattening moves vertices, so it works on copies of the shared operands
+			op1 = shared_ptr<carve::mesh::MeshSet<3> >(op1->clone());
+			op2 = shared_ptr<carve::mesh::MeshSet<3> >(op2->clone());
 			MeshFlattener flat;
 			flat.flattenFacePlanes(op1, op2, paramsScaled);
 		}
@@ -520,12 +569,15 @@ bool CSG_Adapter::computeCSG_Carve(const shared_ptr<carve::mesh::MeshSet<3> >& i
 		bool boolOpDone = false;
 		if (op1->meshes.size() > 1 && operation == carve::csg::CSG::A_MINUS_B)
 		{
+			// inverts meshes of op1 in place
+			op1 = shared_ptr<carve::mesh::MeshSet<3> >(op1->clone());
 			handleInnerOuterMeshesInOperands(op1, op2, result, paramsScaled, boolOpDone, epsDefault);
 		}
 
 		if (!boolOpDone)
 		{
 			carve::csg::CSG csg(epsDefault);
+			setParallelFor(csg, params);
 			result = shared_ptr<carve::mesh::MeshSet<3> >(csg.compute(op1.get(), op2.get(), operation, nullptr, carve::csg::CSG::CLASSIFY_EDGE));
 		}
 
@@ -609,6 +661,7 @@ bool CSG_Adapter::computeCSG_Carve(const shared_ptr<carve::mesh::MeshSet<3> >& i
 		{
 			// no success so far. Try again with CLASSIFY_NORMAL
 			carve::csg::CSG csg(epsDefault);
+			setParallelFor(csg, params);
 			shared_ptr<carve::mesh::MeshSet<3> > resultClassifyNormal(csg.compute(op1.get(), op2.get(), operation, nullptr, carve::csg::CSG::CLASSIFY_NORMAL));
 
 			MeshSetInfo infoResultClassifyNormal;
@@ -779,7 +832,15 @@ void CSG_Adapter::computeCSG(shared_ptr<carve::mesh::MeshSet<3> >& op1, const st
 		return;
 	}
 
+	GeometryProfiler* profiler = params.generalSettings ? params.generalSettings->m_profiler.get() : nullptr;
+	GeometryProfiler::clock_type::time_point time_start_csg;
+	if (profiler)
+	{
+		time_start_csg = GeometryProfiler::clock_type::now();
+	}
+
 	bool success = false;
+	const shared_ptr<carve::mesh::MeshSet<3> > op1Input = op1;
 	std::multimap<double, shared_ptr<carve::mesh::MeshSet<3> > > mapVolumeMeshes;
 	for (const shared_ptr<carve::mesh::MeshSet<3> >&meshset2 : operands2)
 	{
@@ -804,11 +865,42 @@ void CSG_Adapter::computeCSG(shared_ptr<carve::mesh::MeshSet<3> >& op1, const st
 			{1.0,			false,			true,			false,			false,					false }		// one variant without normalizing
 		};
 
+		if (profiler)
+		{
+			++profiler->m_csg_calls;
+			size_t numFaces = 0;
+			for (const carve::mesh::MeshSet<3>* operand : { op1.get(), meshset2.get() })
+			{
+				if (operand)
+				{
+					for (const carve::mesh::Mesh<3>* mesh : operand->meshes)
+					{
+						numFaces += mesh->faces.size();
+					}
+				}
+			}
+			profiler->addCsgOperandFaces(numFaces);
+		}
+
+		NormalizedOperands normalizedOperands;
 		for (size_t ii = 0; ii < vecCsgParams.size(); ++ii)
 		{
 			shared_ptr<carve::mesh::MeshSet<3> > result;
 			CsgOperationParams& csgParams = vecCsgParams[ii];
-			success = computeCSG_Carve(op1, meshset2, operation, result, params, csgParams);
+			success = computeCSG_Carve(op1, meshset2, operation, result, params, csgParams, &normalizedOperands);
+
+			if (profiler)
+			{
+				++profiler->m_csg_attempts;
+				if (ii > 0)
+				{
+					++profiler->m_csg_retries;
+				}
+				else if (!success)
+				{
+					++profiler->m_csg_retried_calls;
+				}
+			}
 
 			if (success)
 			{
@@ -820,6 +912,31 @@ void CSG_Adapter::computeCSG(shared_ptr<carve::mesh::MeshSet<3> >& op1, const st
 				break;
 			}
 		}
+
+		if (!success && profiler)
+		{
+			// all variants failed, op1 stays as it is (see assignResultOnFail)
+			++profiler->m_csg_fallbacks;
+		}
+	}
+
+	// the face trees are only shared by the variants of one operation. Operands and result can be kept until the product is released
+	op1Input->releaseFaceTree();
+	if (op1)
+	{
+		op1->releaseFaceTree();
+	}
+	for (const shared_ptr<carve::mesh::MeshSet<3> >& meshset2 : operands2)
+	{
+		if (meshset2)
+		{
+			meshset2->releaseFaceTree();
+		}
+	}
+
+	if (profiler)
+	{
+		profiler->addCsgTime(GeometryProfiler::clock_type::now() - time_start_csg);
 	}
 }
 
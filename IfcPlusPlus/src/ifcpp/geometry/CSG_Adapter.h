@@ -32,6 +32,9 @@ public:
 
 	static void mergeMeshesToMeshset(std::vector<carve::mesh::Mesh<3>*>& meshes, shared_ptr<carve::mesh::MeshSet<3> >& result, GeomProcessingParams& params);
 
+	//\brief setParallelFor: lets csg distribute its intersection tests on the TaskScheduler of the settings, if there is one
+	static void setParallelFor(carve::csg::CSG& csg, const GeomProcessingParams& params);
+
 	static void assignResultOnFail(const shared_ptr<carve::mesh::MeshSet<3> >& op1, const shared_ptr<carve::mesh::MeshSet<3> >& op2, const carve::csg::CSG::OP operation, shared_ptr<carve::mesh::MeshSet<3> >& result);
 
 	static bool checkBoundingBoxIntersection(const carve::geom::aabb<3>& bbox1, const carve::geom::aabb<3>& bbox2, const carve::csg::CSG::OP operation, double eps);
@@ -45,8 +48,17 @@ public:
 		bool allowFinEdgesInResult = false;
 		bool flattenFacePlanes = false;
 	};
+
+	//\brief NormalizedOperands: normalized operands of one boolean operation, shared by all CsgOperationParams variants with the same normalizeCoords setting.
+	// Steps that modify an operand in place (flattening, splitting inner and outer meshes) work on a copy.
+	struct NormalizedOperands
+	{
+		shared_ptr<carve::mesh::MeshSet<3> > op1[2];
+		shared_ptr<carve::mesh::MeshSet<3> > op2[2];
+	};
+
 	static bool computeCSG_Carve(const shared_ptr<carve::mesh::MeshSet<3> >& inputA, const shared_ptr<carve::mesh::MeshSet<3> >& inputB, const carve::csg::CSG::OP operation, shared_ptr<carve::mesh::MeshSet<3> >& result,
-		GeomProcessingParams& params, CsgOperationParams& csgParams);
+		GeomProcessingParams& params, CsgOperationParams& csgParams, NormalizedOperands* normalizedOperands = nullptr);
 
 	
 	static bool computeCSG_OCC(const shared_ptr<carve::mesh::MeshSet<3> >& inputA, const shared_ptr<carve::mesh::MeshSet<3> >& inputB, const carve::csg::CSG::OP operation, shared_ptr<carve::mesh::MeshSet<3> >& result,
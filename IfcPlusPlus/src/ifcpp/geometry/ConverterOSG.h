@@ -17,6 +17,7 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 
 #pragma once
 
+#include <cstring>
 #include <osg/CullFace>
 #include <osg/Geode>
 #include <osg/Hint>
@@ -671,6 +672,30 @@ public:
 		}
 	}
 
+	//\brief convertFinalizedMesh: FinalizedMeshData can be copied into the vertex, normal and index arrays directly, without triangulation
+	void convertFinalizedMesh(const shared_ptr<FinalizedMeshData>& finalized_mesh, osg::ref_ptr<osg::Geode>& geode)
+	{
+		if (!finalized_mesh || finalized_mesh->getNumTriangles() == 0)
+		{
+			return;
+		}
+
+		const size_t num_vertices = finalized_mesh->getNumVertices();
+		osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(num_vertices);
+		osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array(num_vertices);
+		memcpy(&(*vertices)[0], finalized_mesh->m_positions.data(), num_vertices * 3 * sizeof(float));
+		memcpy(&(*normals)[0], finalized_mesh->m_normals.data(), num_vertices * 3 * sizeof(float));
+
+		osg::ref_ptr<osg::DrawElementsUInt> triangles = new osg::DrawElementsUInt(osg::PrimitiveSet::TRIANGLES, finalized_mesh->m_indices.size());
+		memcpy(&(*triangles)[0], finalized_mesh->m_indices.data(), finalized_mesh->m_indices.size() * sizeof(uint32_t));
+
+		osg::ref_ptr<osg::Geometry> geom = new osg::Geometry();
+		geom->setVertexArray(vertices);
+		geom->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+		geom->addPrimitiveSet(triangles);
+		geode->addDrawable(geom);
+	}
+
 	void convertGeometricItem(const shared_ptr<ItemShapeData>& item_data, shared_ptr<IfcProduct>& ifc_product, size_t ii_representation, size_t ii_item, 
 		osg::ref_ptr<osg::Group>& parentNode, float transparencyOverride)
 	{
@@ -711,6 +736,12 @@ public:
 				convertMeshSets(item_data->m_meshsets, item_geode, ii_item, false);
 			}
 
+			// the finalized mesh contains the triangles of m_meshsets_open and m_meshsets, which are released in case of GeometrySettings::isReleaseHalfEdgeMeshes
+			if (item_data->m_finalized_mesh && item_data->m_meshsets_open.size() == 0 && item_data->m_meshsets.size() == 0)
+			{
+				convertFinalizedMesh(item_data->m_finalized_mesh, item_geode);
+			}
+
 			// create shape for points
 			const std::vector<shared_ptr<carve::input::VertexData> >& vertex_points = item_data->getVertexPoints();
 			for (size_t ii = 0; ii < vertex_points.size(); ++ii)
@@ -419,6 +419,10 @@ void CurveConverter::convertIfcCurve(const shared_ptr<IfcCurve>& ifc_curve, std:
 										{
 											n = m_geom_settings->getMinNumVerticesPerArc();
 										}
+										if (m_geom_settings->isAdaptiveTessellation())
+										{
+											n = m_geom_settings->getNumVerticesPerArc(center_p0.length(), openingAngle);
+										}
 
 										const double deltaAngle = openingAngle / (double)(n - 1);
 										double angle = 0;
@@ -608,8 +612,13 @@ void CurveConverter::convertIfcCurve(const shared_ptr<IfcCurve>& ifc_curve, std:
 			
 		if (circleRadius > epsilonMergePoints*1000)
 		{
-			int num_segments = m_geom_settings->getNumVerticesPerCircleWithRadius(circleRadius) * (std::abs(openingAngle) / (2.0 * M_PI));
-			if (num_segments < m_geom_settings->getMinNumVerticesPerArc()) num_segments = m_geom_settings->getMinNumVerticesPerArc();
+			// with fixed vertex counts, the first semi axis determines the count, as for circles. The tolerances of the adaptive mode need to hold on the larger one
+			double arcRadius = circleRadius;
+			if (m_geom_settings->isAdaptiveTessellation())
+			{
+				arcRadius = std::max(circleRadius, circleRadius2);
+			}
+			int num_segments = m_geom_settings->getNumVerticesPerArc(arcRadius, openingAngle);
 			GeomUtils::getCirclePoints(circleRadius, circleRadius2, startAngle, openingAngle, num_segments,
 				circlePosition, seg.m_points);
 			seg.arcStartAngle = startAngle;
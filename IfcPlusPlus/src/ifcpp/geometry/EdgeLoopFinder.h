@@ -137,6 +137,7 @@ public:
 		if (numPointsMoved > 0 || m_openEdgesMergedToPoint)
 		{
 			meshsetChanged = true;
+			m_meshset->refitFaceTree();
 		}
 	}
 
@@ -291,6 +292,10 @@ public:
 				}
 			}
 		}
+		if (changesDone)
+		{
+			m_meshset->refitFaceTree();
+		}
 		return changesDone;
 	}
 
@@ -550,6 +555,11 @@ public:
 			}
 		}
 
+		if (changesDone)
+		{
+			m_meshset->refitFaceTree();
+		}
+
 		if (m_meshsetCopyUnChanged)
 		{
 			MeshSetInfo infoChangedMesh;
@@ -0,0 +1,478 @@
+/* -*-c++-*- IfcQuery www.ifcquery.com
+*
+MIT License
+
+Copyright (c) 2017 Fabian Gerold
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <map>
+#include <unordered_set>
+#include <vector>
+#include <ifcpp/model/BasicTypes.h>
+#include "IncludeCarveHeaders.h"
+#include "GeomUtils.h"
+#include "GeometryInputData.h"
+#include "GeometrySettings.h"
+#include "MeshOps.h"
+#include "Sweeper.h"
+
+/**
+*\brief Class ExtrudedOpeningSubtractor: fast path for the most common boolean operation, a prismatic element (wall, slab) minus openings
+* that are prisms along the same direction and reach through the whole element.
+* Openings that are enclosed by the cross section are added to it as holes, and the result is extruded once with Sweeper::extrude, without the general CSG.
+* Prisms are detected from the meshes, not from the IFC entities. So a box shaped wall is handled also with window openings along its thickness,
+* although the wall itself is extruded vertically.
+* Openings that don't fit (recesses, doors that cut the boundary of the cross section, overlapping openings, openings at an angle, curved walls)
+* are returned to the caller for the general CSG operation.
+*/
+class ExtrudedOpeningSubtractor
+{
+public:
+	struct PrismSection
+	{
+		std::vector<std::vector<vec2> > m_loops;	// cross section in the 2D frame, outer loops counter-clockwise, holes clockwise
+		double m_minDepth = 0;
+		double m_maxDepth = 0;
+	};
+
+	/**\brief subtractExtrudedOpenings: subtracts the openings that fit the 2D fast path from productMeshSet.
+	\param[in,out] productMeshSet Closed meshset of the element, replaced by the result if at least one opening was subtracted
+	\param[in] openingMeshSets Closed meshsets of all openings, in the same coordinate system as productMeshSet
+	\param[out] remainingOpeningMeshSets Openings that need the general CSG operation
+	\return true if productMeshSet was replaced
+	**/
+	static bool subtractExtrudedOpenings(shared_ptr<carve::mesh::MeshSet<3> >& productMeshSet, const std::vector<shared_ptr<carve::mesh::MeshSet<3> > >& openingMeshSets,
+		std::vector<shared_ptr<carve::mesh::MeshSet<3> > >& remainingOpeningMeshSets, shared_ptr<Sweeper>& sweeper, GeomProcessingParams& params)
+	{
+		remainingOpeningMeshSets = openingMeshSets;
+		if (!productMeshSet || openingMeshSets.size() == 0)
+		{
+			return false;
+		}
+		if (!productMeshSet->isClosed())
+		{
+			return false;
+		}
+
+		const double eps = params.epsMergePoints;
+		const double epsDepth = eps * 10.0;
+		const double epsAngle = 1e-7;
+
+		// the element has to be a prism along the direction of the openings. Candidate directions are the normals of the largest planar regions
+		std::vector<vec3> candidateDirections;
+		collectCandidateDirections(productMeshSet.get(), epsAngle, candidateDirections);
+
+		vec3 bestDirection;
+		PrismSection bestProductSection;
+		std::vector<shared_ptr<PrismSection> > bestOpeningSections;
+		size_t bestNumOpenings = 0;
+
+		for (const vec3& direction : candidateDirections)
+		{
+			vec3 axisU, axisV;
+			computeFrame(direction, axisU, axisV);
+
+			PrismSection productSection;
+			if (!computePrismSection(productMeshSet.get(), direction, axisU, axisV, epsDepth, epsAngle, productSection))
+			{
+				continue;
+			}
+
+			std::vector<shared_ptr<PrismSection> > openingSections;
+			size_t numOpenings = 0;
+			for (const shared_ptr<carve::mesh::MeshSet<3> >& openingMeshSet : openingMeshSets)
+			{
+				shared_ptr<PrismSection> openingSection = make_shared<PrismSection>();
+				bool openingIsPrism = false;
+				if (openingMeshSet && openingMeshSet->isClosed())
+				{
+					openingIsPrism = computePrismSection(openingMeshSet.get(), direction, axisU, axisV, epsDepth, epsAngle, *openingSection);
+				}
+
+				// only openings that reach through the whole element. Recesses need the general CSG
+				if (openingIsPrism && openingSection->m_minDepth <= productSection.m_minDepth + epsDepth && openingSection->m_maxDepth >= productSection.m_maxDepth - epsDepth)
+				{
+					openingSections.push_back(openingSection);
+					++numOpenings;
+				}
+				else
+				{
+					openingSections.push_back(shared_ptr<PrismSection>());
+				}
+			}
+
+			if (numOpenings > bestNumOpenings)
+			{
+				bestNumOpenings = numOpenings;
+				bestDirection = direction;
+				bestProductSection = productSection;
+				bestOpeningSections = openingSections;
+				if (numOpenings == openingMeshSets.size())
+				{
+					break;
+				}
+			}
+		}
+
+		if (bestNumOpenings == 0)
+		{
+			return false;
+		}
+
+		// openings that are enclosed by the cross section become holes, Sweeper::extrude triangulates the caps with the holes.
+		// Openings that touch the boundary of the element or other openings are left to the general CSG
+		std::vector<std::vector<vec2> > resultLoops = bestProductSection.m_loops;
+		std::vector<shared_ptr<carve::mesh::MeshSet<3> > > remaining;
+		size_t numHoles = 0;
+		for (size_t ii = 0; ii < openingMeshSets.size(); ++ii)
+		{
+			const shared_ptr<PrismSection>& openingSection = bestOpeningSections[ii];
+			if (!openingSection || !addOpeningAsHole(resultLoops, openingSection->m_loops, eps))
+			{
+				remaining.push_back(openingMeshSets[ii]);
+				continue;
+			}
+			++numHoles;
+		}
+
+		if (numHoles == 0)
+		{
+			return false;
+		}
+
+		vec3 axisU, axisV;
+		computeFrame(bestDirection, axisU, axisV);
+		double depth = bestProductSection.m_maxDepth - bestProductSection.m_minDepth;
+
+		shared_ptr<ItemShapeData> extrudedItem(new ItemShapeData());
+		sweeper->extrude(resultLoops, carve::geom::VECTOR(0, 0, depth), extrudedItem, params);
+		if (extrudedItem->m_meshsets.size() != 1 || extrudedItem->m_meshsets_open.size() > 0)
+		{
+			// disconnected parts or invalid result
+			return false;
+		}
+
+		shared_ptr<carve::mesh::MeshSet<3> > resultMeshSet = extrudedItem->m_meshsets[0];
+		if (!resultMeshSet || !resultMeshSet->isClosed())
+		{
+			return false;
+		}
+
+		vec3 origin = bestDirection * bestProductSection.m_minDepth;
+		carve::math::Matrix frameMatrix(
+			axisU.x, axisV.x, bestDirection.x, origin.x,
+			axisU.y, axisV.y, bestDirection.y, origin.y,
+			axisU.z, axisV.z, bestDirection.z, origin.z,
+			0, 0, 0, 1);
+		ItemShapeData::applyTransformToMeshSet(resultMeshSet, frameMatrix, eps, false, true);
+
+		productMeshSet = resultMeshSet;
+		remainingOpeningMeshSets.swap(remaining);
+		return true;
+	}
+
+	//\brief computeFrame: right handed frame axisU, axisV, direction
+	static void computeFrame(const vec3& direction, vec3& axisU, vec3& axisV)
+	{
+		vec3 helper = carve::geom::VECTOR(1, 0, 0);
+		if (std::abs(direction.y) < std::abs(direction.x) && std::abs(direction.y) <= std::abs(direction.z))
+		{
+			helper = carve::geom::VECTOR(0, 1, 0);
+		}
+		else if (std::abs(direction.z) < std::abs(direction.x) && std::abs(direction.z) < std::abs(direction.y))
+		{
+			helper = carve::geom::VECTOR(0, 0, 1);
+		}
+		axisU = carve::geom::cross(direction, helper).normalized();
+		axisV = carve::geom::cross(direction, axisU);
+	}
+
+	/**\brief computePrismSection: checks if the meshset is a prism along direction, and computes its cross section.
+	All faces have to be either parallel to the direction, or caps at the minimum or maximum depth along the direction */
+	static bool computePrismSection(const carve::mesh::MeshSet<3>* meshset, const vec3& direction, const vec3& axisU, const vec3& axisV, double epsDepth, double epsAngle, PrismSection& section)
+	{
+		if (meshset->vertex_storage.size() < 6)
+		{
+			return false;
+		}
+
+		double minDepth = DBL_MAX;
+		double maxDepth = -DBL_MAX;
+		for (const carve::mesh::Vertex<3>& vertex : meshset->vertex_storage)
+		{
+			double depth = dot(vertex.v, direction);
+			minDepth = std::min(minDepth, depth);
+			maxDepth = std::max(maxDepth, depth);
+		}
+		if (maxDepth - minDepth < epsDepth * 10.0)
+		{
+			return false;
+		}
+
+		std::unordered_set<const carve::mesh::Face<3>* > setBottomFaces;
+		size_t numBottomEdges = 0;
+		for (const carve::mesh::Mesh<3>* mesh : meshset->meshes)
+		{
+			for (const carve::mesh::Face<3>* face : mesh->faces)
+			{
+				double dotNormal = dot(face->plane.N, direction);
+				if (std::abs(dotNormal) < epsAngle)
+				{
+					// side face
+					continue;
+				}
+				if (std::abs(std::abs(dotNormal) - 1.0) > epsAngle)
+				{
+					return false;
+				}
+
+				// cap face, has to be at the bottom or top of the prism
+				double capDepth = dotNormal < 0 ? minDepth : maxDepth;
+				const carve::mesh::Edge<3>* edge = face->edge;
+				for (size_t ii = 0; ii < face->n_edges; ++ii)
+				{
+					if (std::abs(dot(edge->vert->v, direction) - capDepth) > epsDepth)
+					{
+						return false;
+					}
+					edge = edge->next;
+				}
+
+				if (dotNormal < 0)
+				{
+					setBottomFaces.insert(face);
+					numBottomEdges += face->n_edges;
+				}
+			}
+		}
+
+		if (setBottomFaces.size() == 0)
+		{
+			return false;
+		}
+
+		// boundary edges of the bottom caps, ordered by vertex index, to get the same loops in each run
+		const carve::mesh::Vertex<3>* firstVertex = &meshset->vertex_storage[0];
+		std::map<size_t, const carve::mesh::Edge<3>* > mapBoundaryEdges;
+		for (const carve::mesh::Mesh<3>* mesh : meshset->meshes)
+		{
+			for (const carve::mesh::Face<3>* face : mesh->faces)
+			{
+				if (setBottomFaces.find(face) == setBottomFaces.end())
+				{
+					continue;
+				}
+
+				const carve::mesh::Edge<3>* edge = face->edge;
+				for (size_t ii = 0; ii < face->n_edges; ++ii)
+				{
+					if (!edge->rev)
+					{
+						return false;
+					}
+					if (setBottomFaces.find(edge->rev->face) == setBottomFaces.end())
+					{
+						size_t vertexIndex = edge->vert - firstVertex;
+						if (!mapBoundaryEdges.insert({ vertexIndex, edge }).second)
+						{
+							// non-manifold vertex in cross section
+							return false;
+						}
+					}
+					edge = edge->next;
+				}
+			}
+		}
+
+		section.m_loops.clear();
+		section.m_minDepth = minDepth;
+		section.m_maxDepth = maxDepth;
+		while (mapBoundaryEdges.size() > 0)
+		{
+			const carve::mesh::Edge<3>* startEdge = mapBoundaryEdges.begin()->second;
+			const carve::mesh::Edge<3>* edge = startEdge;
+			std::vector<vec2> loop;
+			while (true)
+			{
+				const vec3& point = edge->vert->v;
+				loop.push_back(carve::geom::VECTOR(dot(point, axisU), dot(point, axisV)));
+				mapBoundaryEdges.erase(edge->vert - firstVertex);
+
+				const carve::mesh::Vertex<3>* nextVertex = edge->next->vert;
+				auto itNext = mapBoundaryEdges.find(nextVertex - firstVertex);
+				if (itNext == mapBoundaryEdges.end())
+				{
+					if (nextVertex != startEdge->vert)
+					{
+						return false;
+					}
+					break;
+				}
+				edge = itNext->second;
+				if (loop.size() > numBottomEdges)
+				{
+					return false;
+				}
+			}
+
+			// bottom faces point against the direction, so the loops are clockwise when seen along the direction
+			std::reverse(loop.begin(), loop.end());
+			section.m_loops.push_back(loop);
+		}
+		return section.m_loops.size() > 0;
+	}
+
+	/**\brief addOpeningAsHole: adds the cross section of an opening as a clockwise hole to the loops of the element cross section.
+	The opening has to be a single loop inside the region of the loops (even-odd rule), and its boundary has to be farther than eps from all other loops.
+	\return false if the opening touches or crosses the boundary of the element or of other openings, or if it encloses other loops */
+	static bool addOpeningAsHole(std::vector<std::vector<vec2> >& loops, const std::vector<std::vector<vec2> >& openingLoops, double eps)
+	{
+		if (openingLoops.size() != 1 || openingLoops[0].size() < 3)
+		{
+			return false;
+		}
+
+		std::vector<vec2> hole = openingLoops[0];
+		size_t numEnclosingLoops = 0;
+		for (const std::vector<vec2>& loop : loops)
+		{
+			if (!boundariesApart(loop, hole, eps))
+			{
+				return false;
+			}
+			if (GeomUtils::pointInPolySimple(hole, loop[0], eps))
+			{
+				// the opening encloses an existing hole or a part of the element
+				return false;
+			}
+			if (GeomUtils::pointInPolySimple(loop, hole[0], eps))
+			{
+				++numEnclosingLoops;
+			}
+		}
+
+		if (numEnclosingLoops % 2 == 0)
+		{
+			// outside of the element, or inside of an existing hole
+			return false;
+		}
+
+		if (GeomUtils::signedArea(hole) > 0)
+		{
+			std::reverse(hole.begin(), hole.end());
+		}
+		loops.push_back(hole);
+		return true;
+	}
+
+protected:
+	//\brief boundariesApart: true if no edges of the two loops cross, and each vertex of one loop is farther than eps from all edges of the other loop
+	static bool boundariesApart(const std::vector<vec2>& loopA, const std::vector<vec2>& loopB, double eps)
+	{
+		carve::geom::aabb<2> bboxA(loopA.begin(), loopA.end());
+		carve::geom::aabb<2> bboxB(loopB.begin(), loopB.end());
+		if (!bboxA.intersects(bboxB, eps))
+		{
+			return true;
+		}
+
+		std::vector<vec2> intersectionPoints;
+		for (size_t ii = 0; ii < loopA.size(); ++ii)
+		{
+			const vec2& pointA0 = loopA[ii];
+			const vec2& pointA1 = loopA[(ii + 1) % loopA.size()];
+			for (size_t jj = 0; jj < loopB.size(); ++jj)
+			{
+				const vec2& pointB0 = loopB[jj];
+				const vec2& pointB1 = loopB[(jj + 1) % loopB.size()];
+				if (GeomUtils::LineSegmentToLineSegmentIntersection(pointA0, pointA1, pointB0, pointB1, eps, intersectionPoints))
+				{
+					return false;
+				}
+				if (distancePointToSegment(pointA0, pointB0, pointB1) <= eps || distancePointToSegment(pointB0, pointA0, pointA1) <= eps)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	static double distancePointToSegment(const vec2& point, const vec2& segmentStart, const vec2& segmentEnd)
+	{
+		const vec2 segment = segmentEnd - segmentStart;
+		const double length2 = segment.length2();
+		double t = 0;
+		if (length2 > 0)
+		{
+			t = std::max(0.0, std::min(1.0, dot(point - segmentStart, segment) / length2));
+		}
+		return (point - (segmentStart + segment * t)).length();
+	}
+
+	/**\brief collectCandidateDirections: normals of planar regions of the meshset, sorted by their area. Opposite normals count as one direction.
+	The number of candidates is limited, for curved elements the fast path does not apply anyway */
+	static void collectCandidateDirections(const carve::mesh::MeshSet<3>* meshset, double epsAngle, std::vector<vec3>& directions)
+	{
+		const size_t maxNumCandidates = 6;
+		std::vector<std::pair<vec3, double> > directionAreas;
+		bool tooManyDirections = false;
+		for (const carve::mesh::Mesh<3>* mesh : meshset->meshes)
+		{
+			for (const carve::mesh::Face<3>* face : mesh->faces)
+			{
+				vec3 normal = face->plane.N;
+				if (normal.x < -epsAngle || (std::abs(normal.x) <= epsAngle && (normal.y < -epsAngle || (std::abs(normal.y) <= epsAngle && normal.z < 0))))
+				{
+					normal = -normal;
+				}
+
+				double area = MeshOps::computeFaceArea(face);
+				bool found = false;
+				for (std::pair<vec3, double>& directionArea : directionAreas)
+				{
+					if (dot(directionArea.first, normal) > 1.0 - epsAngle)
+					{
+						directionArea.second += area;
+						found = true;
+						break;
+					}
+				}
+				if (!found)
+				{
+					if (directionAreas.size() > 64)
+					{
+						// many different face orientations, not a simple prism
+						tooManyDirections = true;
+						break;
+					}
+					directionAreas.push_back({ normal, area });
+				}
+			}
+			if (tooManyDirections)
+			{
+				break;
+			}
+		}
+
+		std::stable_sort(directionAreas.begin(), directionAreas.end(), [](const std::pair<vec3, double>& a, const std::pair<vec3, double>& b) { return a.second > b.second; });
+		for (size_t ii = 0; ii < directionAreas.size() && ii < maxNumCandidates; ++ii)
+		{
+			directions.push_back(directionAreas[ii].first);
+		}
+	}
+};
@@ -962,6 +962,18 @@ public:
 				}
 			}
 
+			if (params.callbackFunc && params.generalSettings && params.generalSettings->isReportSelfIntersections())
+			{
+				std::vector<std::pair<size_t, size_t> > intersectingSegments;
+				GeomUtils::findPolygonSelfIntersections(path_loop_2d, eps, intersectingSegments, true);
+				if (intersectingSegments.size() > 0)
+				{
+					std::stringstream err;
+					err << "face loop is self-intersecting, segment " << intersectingSegments[0].first << " crosses segment " << intersectingSegments[0].second;
+					params.callbackFunc->messageCallback(err.str().c_str(), StatusCallback::MESSAGE_TYPE_MINOR_WARNING, __FUNC__, params.ifc_entity);
+				}
+			}
+
 			// outer loop (biggest area) needs to come first
 			bool insertPositionFound = false;
 			for (size_t iiArea = 0; iiArea < polygon3DArea.size(); ++iiArea)
@@ -18,6 +18,7 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 #pragma once
 
 #include <array>
+#include <map>
 #include <random>
 #include <vector>
 
@@ -1044,6 +1045,71 @@ namespace GeomUtils
 		// TODO: handle all segments separately: std::vector<std::vector<vec3> >& target_vec
 	}
 
+	//\brief UnitCircleTable: cos and sin of i*angle_delta, for i in [0, num_points)
+	struct UnitCircleTable
+	{
+		std::vector<double> cosValues;
+		std::vector<double> sinValues;
+	};
+
+	//\brief getUnitCircleTable: returns the table for the given number of points and angle step. Tables are cached per thread, so no locking is needed.
+	// The returned reference is valid until the next call of getUnitCircleTable in the same thread.
+	inline const UnitCircleTable& getUnitCircleTable(int num_points, double angle_delta)
+	{
+		thread_local std::map<std::pair<int, double>, UnitCircleTable> tableCache;
+
+		std::pair<int, double> key(num_points, angle_delta);
+		auto it = tableCache.find(key);
+		if (it != tableCache.end())
+		{
+			return it->second;
+		}
+
+		if (tableCache.size() > 2000)
+		{
+			// unusual arc spans, each used only once. Do not let the cache grow without limit
+			tableCache.clear();
+		}
+
+		UnitCircleTable& table = tableCache[key];
+		table.cosValues.resize(num_points);
+		table.sinValues.resize(num_points);
+		for (int i = 0; i < num_points; ++i)
+		{
+			const double angle = angle_delta * i;
+			table.cosValues[i] = cos(angle);
+			table.sinValues[i] = sin(angle);
+		}
+		return table;
+	}
+
+	//\brief addEllipseArcPoints: appends num_points points (radius_x*cos(angle) + x_center, radius_y*sin(angle) + y_center), with angle = start_angle + i*angle_delta.
+	// The points are computed by rotating the cached unit circle table by start_angle, so only one cos/sin pair is evaluated per call.
+	inline void addEllipseArcPoints(std::vector<vec2>& coords, double radius_x, double radius_y, double start_angle, double angle_delta, int num_points, double x_center, double y_center)
+	{
+		if (num_points <= 0)
+		{
+			return;
+		}
+
+		const UnitCircleTable& table = getUnitCircleTable(num_points, angle_delta);
+		const double* cosValues = table.cosValues.data();
+		const double* sinValues = table.sinValues.data();
+		const double cosStart = cos(start_angle);
+		const double sinStart = sin(start_angle);
+
+		const size_t offset = coords.size();
+		coords.resize(offset + num_points);
+		vec2* out = coords.data() + offset;
+
+		// cos(a+b) = cos(a)cos(b) - sin(a)sin(b), sin(a+b) = sin(a)cos(b) + cos(a)sin(b). No dependencies between iterations, so the compiler can vectorize this loop
+		for (int i = 0; i < num_points; ++i)
+		{
+			out[i].x = radius_x * (cosStart * cosValues[i] - sinStart * sinValues[i]) + x_center;
+			out[i].y = radius_y * (sinStart * cosValues[i] + cosStart * sinValues[i]) + y_center;
+		}
+	}
+
 	inline void addArcWithEndPoint(std::vector<vec2>& coords, double radius, double start_angle, double opening_angle, double x_center, double y_center, int num_segments)
 	{
 		if (num_segments < 3)
@@ -1056,34 +1122,36 @@ namespace GeomUtils
 			num_segments = 100;
 		}
 
-		double angle = start_angle;
 		double angle_delta = opening_angle / (double)(num_segments - 1);
-		for (int i = 0; i < num_segments; ++i)
-		{
-			coords.push_back(carve::geom::VECTOR(radius * cos(angle) + x_center, radius * sin(angle) + y_center));
-			angle += angle_delta;
-		}
+		addEllipseArcPoints(coords, radius, radius, start_angle, angle_delta, num_segments, x_center, y_center);
 	}
 
 	inline void getCirclePoints(double circle_radius, double circle_radius2, double startAngle, double openingAngle, int num_segments, const carve::math::Matrix& matrix,
 		std::vector<vec3>& circle_segment_points3D)
 	{
-		double angle = startAngle;
-		double angle_delta = openingAngle / (double)(num_segments - 1);
-
-		for (int i = 0; i < num_segments; ++i)
+		if (num_segments <= 0)
 		{
-			vec3 circlePoint = carve::geom::VECTOR(circle_radius * cos(angle), circle_radius * sin(angle), 0);
-			if (circle_radius2 > 0)
-			{
-				circlePoint = carve::geom::VECTOR(circle_radius * cos(angle), circle_radius2 * sin(angle), 0);
-			}
+			return;
+		}
+
+		double angle_delta = num_segments > 1 ? openingAngle / (double)(num_segments - 1) : 0.0;
+		double radiusY = circle_radius2 > 0 ? circle_radius2 : circle_radius;
 
-			// apply position
-			circlePoint = matrix * circlePoint;
+		thread_local std::vector<vec2> circlePoints2D;
+		circlePoints2D.clear();
+		addEllipseArcPoints(circlePoints2D, circle_radius, radiusY, startAngle, angle_delta, num_segments, 0, 0);
 
-			circle_segment_points3D.push_back(circlePoint);
-			angle += angle_delta;
+		// apply position. The points are in the xy plane, so only the first two columns and the translation of the matrix are needed
+		const size_t offset = circle_segment_points3D.size();
+		circle_segment_points3D.resize(offset + num_segments);
+		vec3* out = circle_segment_points3D.data() + offset;
+		for (int i = 0; i < num_segments; ++i)
+		{
+			const double x = circlePoints2D[i].x;
+			const double y = circlePoints2D[i].y;
+			out[i].x = matrix._11 * x + matrix._21 * y + matrix._41;
+			out[i].y = matrix._12 * x + matrix._22 * y + matrix._42;
+			out[i].z = matrix._13 * x + matrix._23 * y + matrix._43;
 		}
 	}
 
@@ -1295,38 +1363,165 @@ namespace GeomUtils
 		closestPointOnLine2 = point1OnLine2 + (Line2Factor * Line2Direction);
 	}
 
-	inline bool isPolygonSelfIntersecting(const std::vector<vec2>& polygon, double eps)
+	/** \brief findPolygonSelfIntersections: finds all pairs of segments of a closed polygon that cross each other. Segment i goes from polygon[i] to polygon[(i+1)%n].
+	* Segments are sorted into a uniform grid of about sqrt(n) x sqrt(n) cells, and only segments in a common cell are tested against each other. 
+	* The result is sorted, and each pair is reported once, with the lower segment index first.
+	* \param[in] stopAtFirst: return after the first intersection, if the caller only needs to know if there is any
+	**/
+	inline void findPolygonSelfIntersections(const std::vector<vec2>& polygon, double eps, std::vector<std::pair<size_t, size_t> >& intersectingSegments, bool stopAtFirst = false)
 	{
-		size_t numPoints = polygon.size();
+		const size_t numPoints = polygon.size();
 		if (numPoints < 4)
 		{
+			return;
+		}
+
+		auto testSegments = [&](size_t ii, size_t jj) -> bool
+		{
+			double r, s;
+			if (LineToLineIntersectionHelper(polygon[ii], polygon[(ii + 1) % numPoints], polygon[jj], polygon[(jj + 1) % numPoints], r, s, eps))
+			{
+				if (r > eps && r < 1.0 - eps && s > eps && s < 1.0 - eps)
+				{
+					intersectingSegments.push_back({ ii, jj });
+					return true;
+				}
+			}
 			return false;
+		};
+
+		if (numPoints < 32)
+		{
+			// for small polygons, the grid does not pay off
+			for (size_t ii = 0; ii < numPoints; ++ii)
+			{
+				for (size_t jj = ii + 1; jj < numPoints; ++jj)
+				{
+					if (testSegments(ii, jj) && stopAtFirst)
+					{
+						return;
+					}
+				}
+			}
+			return;
 		}
-		for (int ii = 0; ii < numPoints; ++ii)
+
+		vec2 bboxMin = polygon[0];
+		vec2 bboxMax = polygon[0];
+		for (const vec2& point : polygon)
 		{
-			const vec2& p1 = polygon[ii];
-			const vec2& p2 = polygon[(ii + 1)%numPoints];
-			for (int jj = 0; jj < numPoints; ++jj)
+			bboxMin.x = std::min(bboxMin.x, point.x);
+			bboxMin.y = std::min(bboxMin.y, point.y);
+			bboxMax.x = std::max(bboxMax.x, point.x);
+			bboxMax.y = std::max(bboxMax.y, point.y);
+		}
+
+		const size_t gridSize = std::max(size_t(1), size_t(std::sqrt(double(numPoints))));
+		const double extentX = bboxMax.x - bboxMin.x;
+		const double extentY = bboxMax.y - bboxMin.y;
+		const double cellFactorX = extentX > 0 ? double(gridSize) / extentX : 0;
+		const double cellFactorY = extentY > 0 ? double(gridSize) / extentY : 0;
+		auto cellX = [&](double x) { return std::min(gridSize - 1, size_t((x - bboxMin.x) * cellFactorX)); };
+		auto cellY = [&](double y) { return std::min(gridSize - 1, size_t((y - bboxMin.y) * cellFactorY)); };
+
+		// cell range of each segment
+		std::vector<std::array<size_t, 4> > segmentCells(numPoints);
+		std::vector<size_t> cellStart(gridSize * gridSize + 1, 0);
+		for (size_t ii = 0; ii < numPoints; ++ii)
+		{
+			const vec2& p0 = polygon[ii];
+			const vec2& p1 = polygon[(ii + 1) % numPoints];
+			std::array<size_t, 4>& cells = segmentCells[ii];
+			cells = { cellX(std::min(p0.x, p1.x)), cellY(std::min(p0.y, p1.y)), cellX(std::max(p0.x, p1.x)), cellY(std::max(p0.y, p1.y)) };
+			for (size_t cy = cells[1]; cy <= cells[3]; ++cy)
 			{
-				if (ii == jj) { continue; }
-				const vec2& p1a = polygon[jj];
-				const vec2& p2a = polygon[(jj + 1) % numPoints];
+				for (size_t cx = cells[0]; cx <= cells[2]; ++cx)
+				{
+					++cellStart[cy * gridSize + cx + 1];
+				}
+			}
+		}
 
-				std::vector<vec2> result;
-				bool intersects = LineSegmentToLineSegmentIntersection(p1, p2, p1a, p2a, eps, result);
-				if (intersects)
+		// segments of each cell in one flat array
+		for (size_t ii = 1; ii < cellStart.size(); ++ii)
+		{
+			cellStart[ii] += cellStart[ii - 1];
+		}
+		std::vector<size_t> cellSegments(cellStart.back());
+		std::vector<size_t> cellFill(cellStart.begin(), cellStart.end() - 1);
+		for (size_t ii = 0; ii < numPoints; ++ii)
+		{
+			const std::array<size_t, 4>& cells = segmentCells[ii];
+			for (size_t cy = cells[1]; cy <= cells[3]; ++cy)
+			{
+				for (size_t cx = cells[0]; cx <= cells[2]; ++cx)
 				{
-#ifdef _DEBUG
-					vec4 color(0.4, 0.6, 0.9, 1.0);
-					std::vector<vec2> segment1 = { p1, p2 };
-					GeomDebugDump::dumpPolyline(segment1, color, 2.0, false, false);
-					std::vector<vec2> segment2 = { p1a, p2a };
-					GeomDebugDump::dumpPolyline(segment2, color, 2.0, false, false);
-#endif
-					return true;
+					cellSegments[cellFill[cy * gridSize + cx]++] = ii;
+				}
+			}
+		}
+
+		for (size_t cy = 0; cy < gridSize; ++cy)
+		{
+			for (size_t cx = 0; cx < gridSize; ++cx)
+			{
+				const size_t cellIndex = cy * gridSize + cx;
+				for (size_t kk = cellStart[cellIndex]; kk < cellStart[cellIndex + 1]; ++kk)
+				{
+					const size_t ii = cellSegments[kk];
+					const std::array<size_t, 4>& cellsI = segmentCells[ii];
+					for (size_t ll = kk + 1; ll < cellStart[cellIndex + 1]; ++ll)
+					{
+						const size_t jj = cellSegments[ll];
+						const std::array<size_t, 4>& cellsJ = segmentCells[jj];
+
+						// segments that share several cells are tested only in the first one
+						if (cx != std::max(cellsI[0], cellsJ[0]) || cy != std::max(cellsI[1], cellsJ[1]))
+						{
+							continue;
+						}
+
+						if (testSegments(std::min(ii, jj), std::max(ii, jj)) && stopAtFirst)
+						{
+							return;
+						}
+					}
 				}
 			}
 		}
+
+		std::sort(intersectingSegments.begin(), intersectingSegments.end());
+	}
+
+	inline void findPolygonSelfIntersections(const std::vector<array2d>& polygon, double eps, std::vector<std::pair<size_t, size_t> >& intersectingSegments, bool stopAtFirst = false)
+	{
+		std::vector<vec2> polygon2d;
+		polygon2d.reserve(polygon.size());
+		for (const array2d& point : polygon)
+		{
+			polygon2d.push_back(carve::geom::VECTOR(point[0], point[1]));
+		}
+		findPolygonSelfIntersections(polygon2d, eps, intersectingSegments, stopAtFirst);
+	}
+
+	inline bool isPolygonSelfIntersecting(const std::vector<vec2>& polygon, double eps)
+	{
+		std::vector<std::pair<size_t, size_t> > intersectingSegments;
+		findPolygonSelfIntersections(polygon, eps, intersectingSegments, true);
+		if (intersectingSegments.size() > 0)
+		{
+#ifdef _DEBUG
+			const size_t numPoints = polygon.size();
+			const size_t ii = intersectingSegments[0].first;
+			const size_t jj = intersectingSegments[0].second;
+			vec4 color(0.4, 0.6, 0.9, 1.0);
+			std::vector<vec2> segment1 = { polygon[ii], polygon[(ii + 1) % numPoints] };
+			GeomDebugDump::dumpPolyline(segment1, color, 2.0, false, false);
+			std::vector<vec2> segment2 = { polygon[jj], polygon[(jj + 1) % numPoints] };
+			GeomDebugDump::dumpPolyline(segment2, color, 2.0, false, false);
+#endif
+			return true;
+		}
 		return false;
 	}
 
@@ -1607,6 +1802,7 @@ namespace GeomUtils
 		//{
 		//	meshset->meshes[i]->recalc(eps);
 		//}
+		meshset->refitFaceTree();
 	}
 	inline void applyTransform(shared_ptr<carve::mesh::MeshSet<3> >& meshset, const carve::math::Matrix& matrix, double eps)
 	{
@@ -1619,6 +1815,7 @@ namespace GeomUtils
 		{
 			meshset->meshes[i]->recalc(eps);
 		}
+		meshset->refitFaceTree();
 	}
 	inline void applyTransform(carve::geom::aabb<3>& aabb, const carve::math::Matrix& matrix)
 	{
@@ -19,9 +19,12 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 
 // #define _DEBUG_LOOP_SEQENTIAL  // define for debugging geometry conversion
 
+#include <algorithm>
+#include <atomic>
 #include <map>
 #include <thread>
 #include <unordered_set>
+#include <ifcpp/model/AttributeObject.h>
 #include <ifcpp/model/BasicTypes.h>
 #include <ifcpp/model/BuildingModel.h>
 #include <ifcpp/model/StatusCallback.h>
@@ -32,19 +35,26 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 #include <ifcpp/IFC4X3/include/IfcDistributionElement.h>
 #include <ifcpp/IFC4X3/include/IfcGloballyUniqueId.h>
 #include <ifcpp/IFC4X3/include/IfcIndexedColourMap.h>
+#include <ifcpp/IFC4X3/include/IfcManifoldSolidBrep.h>
+#include <ifcpp/IFC4X3/include/IfcMaterial.h>
+#include <ifcpp/IFC4X3/include/IfcMaterialDefinitionRepresentation.h>
+#include <ifcpp/IFC4X3/include/IfcOwnerHistory.h>
 #include <ifcpp/IFC4X3/include/IfcDistributionPort.h>
 #include <ifcpp/IFC4X3/include/IfcPropertySetDefinitionSet.h>
 #include <ifcpp/IFC4X3/include/IfcRelAggregates.h>
 #include <ifcpp/IFC4X3/include/IfcRelAssigns.h>
+#include <ifcpp/IFC4X3/include/IfcRelAssociatesMaterial.h>
 #include <ifcpp/IFC4X3/include/IfcRelAssignsToGroup.h>
 #include <ifcpp/IFC4X3/include/IfcRelConnectsPortToElement.h>
 #include <ifcpp/IFC4X3/include/IfcRelContainedInSpatialStructure.h>
 #include <ifcpp/IFC4X3/include/IfcRelDefinesByProperties.h>
 #include <ifcpp/IFC4X3/include/IfcRelServicesBuildings.h>
 #include <ifcpp/IFC4X3/include/IfcRelSpaceBoundary.h>
+#include <ifcpp/IFC4X3/include/IfcRelVoidsElement.h>
 #include <ifcpp/IFC4X3/include/IfcShapeRepresentation.h>
 #include <ifcpp/IFC4X3/include/IfcSite.h>
 #include <ifcpp/IFC4X3/include/IfcSpace.h>
+#include <ifcpp/IFC4X3/include/IfcStyledItem.h>
 #include <ifcpp/IFC4X3/include/IfcSystem.h>
 #include <ifcpp/IFC4X3/include/IfcTypeObject.h>
 #include <ifcpp/IFC4X3/include/IfcWindow.h>
@@ -52,9 +62,20 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 
 #include "IncludeCarveHeaders.h"
 #include "GeometryInputData.h"
+#include "GeometryProfiler.h"
 #include "RepresentationConverter.h"
 #include "CSG_Adapter.h"
 #include "MeshSimplifier.h"
+#include "MeshFinalizer.h"
+
+//\brief ProductStructureNode: lightweight node of the spatial structure (IfcProject -> IfcSite -> IfcBuilding -> IfcBuildingStorey -> IfcWall...), without geometry
+struct ProductStructureNode
+{
+	std::string guid;
+	int tag = -1;
+	uint32_t classID = 0;
+	std::vector<shared_ptr<ProductStructureNode> > children;
+};
 
 class GeometryConverter : public StatusCallback
 {
@@ -70,10 +91,12 @@ protected:
 	double m_recent_progress = 0;
 	bool m_convertDirectlyToBuffer = true;
 	std::unordered_map<int, std::vector<shared_ptr<StatusCallback::Message> > > m_messages;
+	shared_ptr<ProductStructureNode> m_spatial_structure_tree;
 
 	std::mutex m_writelock_messages;
 	std::mutex m_writelock_item_cache;
 	std::mutex m_writelock_progress;
+	std::mutex m_writelock_element_converted;
 
 public:
 	// getters and setters
@@ -86,13 +109,41 @@ public:
 	bool m_clear_memory_immedeately = true;
 	bool m_set_model_to_origin = false;
 
-	//\ brief: ElementConvertedCallback will be called after each IfcProduct geometry is converted, in case you want to directly stream the meshes somewhere
-	//using ElementConvertedCallbackType = std::function<void(shared_ptr<ProductShapeData>)>;
-	//ElementConvertedCallbackType elementConvertedCallbackHandler;
-	//void setElementConvertedCallback(const ElementConvertedCallbackType& cb)
-	//{
-	//	elementConvertedCallbackHandler = cb;
-	//}
+	//\brief m_track_dependencies: if set, each ProductShapeData records the IFC entities its geometry is created from, so that updateGeometry can recompute only affected products
+	bool m_track_dependencies = false;
+
+	/**\brief setProfilingEnabled: attaches a GeometryProfiler to the geometry settings, which records the time per product and per representation item type, CSG statistics and profile cache hits.
+	The profiler is reset at the start of each convertGeometry run. getProfiler()->getProductEvents() returns the time of each product, slowest first.
+	Export the results with getProfiler()->toJSON() or getProfiler()->toChromeTrace() */
+	void setProfilingEnabled(bool enabled)
+	{
+		if (!enabled)
+		{
+			m_geom_settings->m_profiler.reset();
+		}
+		else if (!m_geom_settings->m_profiler)
+		{
+			m_geom_settings->m_profiler = make_shared<GeometryProfiler>();
+		}
+	}
+
+	//\brief getProfiler: null if profiling is not enabled
+	shared_ptr<GeometryProfiler>& getProfiler() { return m_geom_settings->m_profiler; }
+
+	//\brief getSpatialStructureTree: spatial structure of the last convertGeometry run, starting at IfcProject. Products are referenced by GUID only
+	const shared_ptr<ProductStructureNode>& getSpatialStructureTree() { return m_spatial_structure_tree; }
+
+	/**\brief ElementConvertedCallback will be called after each IfcProduct geometry is converted (including its openings), in case you want to directly stream the meshes somewhere.
+	If set, convertGeometry runs in streaming mode: the converter releases its own reference to the meshes right after the callback, so that the peak memory
+	depends on the number of threads, not on the size of the model. Child products are not attached to their parents (use getSpatialStructureTree instead),
+	and getShapeInputData is empty after convertGeometry.
+	The callback is called from the worker threads, but never concurrently */
+	using ElementConvertedCallbackType = std::function<void(shared_ptr<ProductShapeData>&)>;
+	ElementConvertedCallbackType elementConvertedCallbackHandler;
+	void setElementConvertedCallback(const ElementConvertedCallbackType& cb)
+	{
+		elementConvertedCallbackHandler = cb;
+	}
 
 	GeometryConverter(shared_ptr<BuildingModel>& ifc_model, shared_ptr<GeometrySettings>& geom_settings)
 	{
@@ -131,6 +182,7 @@ public:
 		m_setResolvedProjectStructure.clear();
 		m_representation_converter->clearCache();
 		m_messages.clear();
+		m_spatial_structure_tree.reset();
 	}
 
 	void clearIfcRepresentationsInModel(bool resetRepresentationInProducts, bool clearStyles, bool clearIfcElements )
@@ -738,7 +790,14 @@ public:
 		m_map_outside_spatial_structure.clear();
 		m_setResolvedProjectStructure.clear();
 		m_representation_converter->clearCache();
+		m_spatial_structure_tree.reset();
 		m_clear_memory_immedeately = false;
+		GeometryProfiler* profiler = m_geom_settings->m_profiler.get();
+		if (profiler)
+		{
+			profiler->reset();
+		}
+		const bool streaming = elementConvertedCallbackHandler != nullptr;
 
 		if (!m_ifc_model)
 		{
@@ -752,14 +811,33 @@ public:
 		// create geometry for for each IfcProduct independently, spatial structure will be resolved later
 		const int num_object_definitions = (int)vecObjectDefinitions.size();
 
+		// schedule expensive products first, so that a single large product does not end up as the last task, running alone on one thread
+		std::vector<std::pair<size_t, shared_ptr<IfcObjectDefinition> > > vecScheduledObjects;
+		vecScheduledObjects.reserve(vecObjectDefinitions.size());
+		for (const shared_ptr<IfcObjectDefinition>& object_def : vecObjectDefinitions)
+		{
+			vecScheduledObjects.push_back({ estimateConversionCost(object_def), object_def });
+		}
+		std::stable_sort(vecScheduledObjects.begin(), vecScheduledObjects.end(), [](const std::pair<size_t, shared_ptr<IfcObjectDefinition> >& a, const std::pair<size_t, shared_ptr<IfcObjectDefinition> >& b) { return a.first > b.first; });
+
+		shared_ptr<TaskScheduler>& task_scheduler = m_representation_converter->getTaskScheduler();
+		task_scheduler->setNumThreads(m_geom_settings->getNumThreads());
+
 		std::mutex writelock_map, writelock_ifc_project, writelock_err;
-		int ii = 0;
-		FOR_EACH_LOOP vecObjectDefinitions.begin(), vecObjectDefinitions.end(), [&](shared_ptr<IfcObjectDefinition>& object_def) {
+		std::atomic<int> num_products_done(0);
+		std::atomic<bool> canceled(false);
+		task_scheduler->parallelForEach(vecScheduledObjects.begin(), vecScheduledObjects.end(), [&](std::pair<size_t, shared_ptr<IfcObjectDefinition> >& scheduled_object) {
 
-				if (m_ifc_model->isLoadingCancelled())
+				shared_ptr<IfcObjectDefinition>& object_def = scheduled_object.second;
+				if (canceled.load())
 				{
 					return;
 				}
+				if (m_ifc_model->isLoadingCancelled() || isCanceled())
+				{
+					canceled.store(true);
+					return;
+				}
 
 				const int tag = object_def->m_tag;
 				std::string guid;
@@ -791,6 +869,7 @@ public:
 
 				try
 				{
+					GeometryProfiler::ScopedProductTimer profile_product(profiler, tag, classID, guid);
 					convertIfcProductShape(product_geom_input_data);
 				}
 				catch (BuildingException& e)
@@ -810,6 +889,18 @@ public:
 					thread_err << "undefined error, product id " << tag;
 				}
 
+				if (streaming && !dependsOnOpeningsOfRelatingElement(object_def))
+				{
+					// the product is complete, hand it over and keep only a placeholder without geometry for the spatial structure
+					sendElementConverted(product_geom_input_data);
+					product_geom_input_data = createPlaceholderShapeData(product_geom_input_data);
+					if (classID == IFCPROJECT)
+					{
+						std::lock_guard<std::mutex> lock(writelock_ifc_project);
+						ifcProjectData = product_geom_input_data;
+					}
+				}
+
 				{
 					std::lock_guard<std::mutex> lock(writelock_map);
 					m_product_shape_data[guid] = product_geom_input_data;
@@ -821,14 +912,31 @@ public:
 				}
 
 				// progress callback
-				double progress = (double)ii / (double)num_object_definitions;
+				int num_done = ++num_products_done;
+				double progress = (double)num_done / (double)num_object_definitions;
 				sendProgress(progress);
-				++ii;
 			});
 
+		if (canceled.load())
+		{
+			m_product_shape_data.clear();
+			canceledCallback();
+			return;
+		}
+
 		// subtract openings in assemblies etc, in case the opening is attached at the top level
-		ii = 0;
-		FOR_EACH_LOOP vecObjectDefinitions.begin(), vecObjectDefinitions.end(), [&](shared_ptr<IfcObjectDefinition>& object_def) {
+		num_products_done = 0;
+		task_scheduler->parallelForEach(vecObjectDefinitions.begin(), vecObjectDefinitions.end(), [&](shared_ptr<IfcObjectDefinition>& object_def) {
+			if (canceled.load())
+			{
+				return;
+			}
+			if (m_ifc_model->isLoadingCancelled() || isCanceled())
+			{
+				canceled.store(true);
+				return;
+			}
+
 			std::string guid;
 			if (object_def->m_GlobalId)
 			{
@@ -838,20 +946,326 @@ public:
 			if (it_find != m_product_shape_data.end())
 			{
 				shared_ptr<ProductShapeData> product_geom_input_data = it_find->second;
-				subtractOpeningsInRelatedObjects(product_geom_input_data);
+				try
+				{
+					subtractOpeningsInRelatedObjects(product_geom_input_data);
+				}
+				catch (BuildingException& e)
+				{
+					messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", object_def.get());
+				}
+				catch (carve::exception& e)
+				{
+					messageCallback(e.str(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, object_def.get());
+				}
+				catch (std::exception& e)
+				{
+					messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, object_def.get());
+				}
+				catch (...)
+				{
+					messageCallback("undefined error", StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, object_def.get());
+				}
 			}
 
-			double progress = 0.8 + 0.1* (double)ii / (double)num_object_definitions;
+			int num_done = ++num_products_done;
+			double progress = 0.8 + 0.1* (double)num_done / (double)num_object_definitions;
 			sendProgress(progress);
-			++ii;
 		});
 
-		if (m_ifc_model->isLoadingCancelled())
+		if (canceled.load() || m_ifc_model->isLoadingCancelled())
 		{
 			m_product_shape_data.clear();
+			canceledCallback();
 			return;
 		}
-				
+
+		if (!streaming && (m_geom_settings->getLevelsOfDetail().size() > 0 || m_geom_settings->isCreateFinalizedMeshes()))
+		{
+			// all openings are subtracted now, so the meshes are final. In streaming mode, products are finalized in sendElementConverted
+			std::vector<shared_ptr<ProductShapeData> > vecProductShapes;
+			vecProductShapes.reserve(m_product_shape_data.size());
+			for (auto& it_product_shape : m_product_shape_data)
+			{
+				vecProductShapes.push_back(it_product_shape.second);
+			}
+			task_scheduler->parallelForEach(vecProductShapes.begin(), vecProductShapes.end(), [&](shared_ptr<ProductShapeData>& product_shape) {
+				try
+				{
+					finalizeProductShape(product_shape);
+				}
+				catch (std::exception& e)
+				{
+					messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, nullptr);
+				}
+				catch (...)
+				{
+					messageCallback("undefined error", StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, nullptr);
+				}
+			});
+		}
+
+		if (streaming)
+		{
+			// products inside an element with openings (IfcElementAssembly for example) are complete only now
+			for (auto& it_product_shape : m_product_shape_data)
+			{
+				shared_ptr<ProductShapeData>& product_shape = it_product_shape.second;
+				if (!product_shape || product_shape->m_ifc_object_definition.expired())
+				{
+					continue;
+				}
+				shared_ptr<IfcObjectDefinition> ifc_object_def(product_shape->m_ifc_object_definition);
+				if (dependsOnOpeningsOfRelatingElement(ifc_object_def))
+				{
+					sendElementConverted(product_shape);
+					product_shape = createPlaceholderShapeData(product_shape);
+					if (ifc_object_def->classID() == IFCPROJECT)
+					{
+						ifcProjectData = product_shape;
+					}
+				}
+			}
+		}
+
+		resolveSpatialStructure(ifcProjectData);
+
+		if (streaming)
+		{
+			// all meshes have been handed over already
+			m_product_shape_data.clear();
+		}
+
+		m_representation_converter->clearCache();
+		carve::mesh::release_cached_blocks();
+		progressTextCallback("Loading file done");
+		progressValueCallback(1.0, "geometry");
+	}
+
+	/*\brief method updateGeometry: Recomputes only the products whose geometry depends on one of the modified entities, all other meshes are kept.
+	* New products in modifiedEntityTags are converted, products that have been removed from the model are removed.
+	* Requires m_track_dependencies during the previous convertGeometry, otherwise the complete model is converted again.
+	**/
+	void updateGeometry(const std::vector<int>& modifiedEntityTags)
+	{
+		if (!m_ifc_model)
+		{
+			return;
+		}
+
+		if (!m_track_dependencies || m_product_shape_data.empty() || elementConvertedCallbackHandler)
+		{
+			convertGeometry();
+			return;
+		}
+
+		progressTextCallback("Updating geometry...");
+		printToDebugLog(__FUNC__, "start updating");
+		m_clear_memory_immedeately = false;
+
+		// cached profiles may have been modified
+		m_representation_converter->clearCache();
+
+		std::unordered_set<int> setModifiedTags(modifiedEntityTags.begin(), modifiedEntityTags.end());
+		const BuildingModelMapType<int, shared_ptr<BuildingEntity> >& map_entities = m_ifc_model->getMapIfcEntities();
+
+		// relationships and styles that did not exist in the previous conversion are not in any dependency list yet, so mark the objects they refer to as modified
+		for (int tag : modifiedEntityTags)
+		{
+			auto it_find = map_entities.find(tag);
+			if (it_find == map_entities.end())
+			{
+				continue;
+			}
+			collectRelatedObjectTags(it_find->second, setModifiedTags);
+		}
+		std::vector<shared_ptr<IfcObjectDefinition> > vecObjectDefinitionsToUpdate;
+		std::unordered_set<int> setTagsToUpdate;
+
+		for (auto it = m_product_shape_data.begin(); it != m_product_shape_data.end(); )
+		{
+			shared_ptr<ProductShapeData>& product_shape = it->second;
+			shared_ptr<IfcObjectDefinition> ifc_object_def;
+			if (product_shape)
+			{
+				ifc_object_def = product_shape->m_ifc_object_definition.lock();
+			}
+			if (!ifc_object_def || map_entities.find(ifc_object_def->m_tag) == map_entities.end())
+			{
+				// product has been deleted
+				it = m_product_shape_data.erase(it);
+				continue;
+			}
+
+			bool modified = setModifiedTags.find(ifc_object_def->m_tag) != setModifiedTags.end();
+			for (size_t ii = 0; ii < product_shape->m_dependencies.size() && !modified; ++ii)
+			{
+				modified = setModifiedTags.find(product_shape->m_dependencies[ii]) != setModifiedTags.end();
+			}
+
+			if (modified)
+			{
+				vecObjectDefinitionsToUpdate.push_back(ifc_object_def);
+				setTagsToUpdate.insert(ifc_object_def->m_tag);
+			}
+			++it;
+		}
+
+		// products that did not exist in the previous conversion
+		for (int tag : modifiedEntityTags)
+		{
+			if (setTagsToUpdate.find(tag) != setTagsToUpdate.end())
+			{
+				continue;
+			}
+			auto it_find = map_entities.find(tag);
+			if (it_find == map_entities.end())
+			{
+				continue;
+			}
+			shared_ptr<IfcProduct> ifc_product = dynamic_pointer_cast<IfcProduct>(it_find->second);
+			if (ifc_product && ifc_product->m_GlobalId)
+			{
+				if (m_product_shape_data.find(ifc_product->m_GlobalId->m_value) == m_product_shape_data.end())
+				{
+					vecObjectDefinitionsToUpdate.push_back(ifc_product);
+					setTagsToUpdate.insert(tag);
+				}
+			}
+		}
+
+		std::vector<std::pair<shared_ptr<IfcObjectDefinition>, shared_ptr<ProductShapeData> > > vecUpdatedProducts;
+		for (const shared_ptr<IfcObjectDefinition>& object_def : vecObjectDefinitionsToUpdate)
+		{
+			if (!m_geom_settings->skipRenderObject(object_def->classID()))
+			{
+				vecUpdatedProducts.push_back({ object_def, shared_ptr<ProductShapeData>() });
+			}
+		}
+
+		GeometryProfiler* profiler = m_geom_settings->m_profiler.get();
+		if (profiler)
+		{
+			profiler->removeProductEvents(setTagsToUpdate);
+		}
+
+		shared_ptr<TaskScheduler>& task_scheduler = m_representation_converter->getTaskScheduler();
+		task_scheduler->setNumThreads(m_geom_settings->getNumThreads());
+		std::atomic<bool> canceled(false);
+		task_scheduler->parallelForEach(vecUpdatedProducts.begin(), vecUpdatedProducts.end(), [&](std::pair<shared_ptr<IfcObjectDefinition>, shared_ptr<ProductShapeData> >& update_task) {
+			if (canceled.load())
+			{
+				return;
+			}
+			if (m_ifc_model->isLoadingCancelled() || isCanceled())
+			{
+				canceled.store(true);
+				return;
+			}
+
+			shared_ptr<IfcObjectDefinition>& object_def = update_task.first;
+			std::string guid;
+			if (object_def->m_GlobalId)
+			{
+				guid = object_def->m_GlobalId->m_value;
+			}
+
+			shared_ptr<ProductShapeData> product_shape = make_shared<ProductShapeData>(guid);
+			product_shape->m_ifc_object_definition = object_def;
+			try
+			{
+				GeometryProfiler::ScopedProductTimer profile_product(profiler, object_def->m_tag, object_def->classID(), guid);
+				convertIfcProductShape(product_shape);
+
+				// openings of a relating element, for example an IfcElementAssembly
+				for (const weak_ptr<IfcRelAggregates>& rel_aggregates_weak : object_def->m_Decomposes_inverse)
+				{
+					shared_ptr<IfcRelAggregates> rel_aggregates = rel_aggregates_weak.lock();
+					if (rel_aggregates)
+					{
+						shared_ptr<IfcElement> relating_element = dynamic_pointer_cast<IfcElement>(rel_aggregates->m_RelatingObject);
+						if (relating_element)
+						{
+							m_representation_converter->subtractOpenings(relating_element, product_shape);
+						}
+					}
+				}
+
+				finalizeProductShape(product_shape);
+			}
+			catch (BuildingException& e)
+			{
+				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", object_def.get());
+			}
+			catch (carve::exception& e)
+			{
+				messageCallback(e.str(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, object_def.get());
+			}
+			catch (std::exception& e)
+			{
+				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, object_def.get());
+			}
+			catch (...)
+			{
+				messageCallback("undefined error", StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, object_def.get());
+			}
+			update_task.second = product_shape;
+		});
+
+		if (canceled.load() || m_ifc_model->isLoadingCancelled())
+		{
+			m_product_shape_data.clear();
+			canceledCallback();
+			return;
+		}
+
+		// remove the previous shapes by entity tag, since the GlobalId of a product may have been changed
+		for (auto it = m_product_shape_data.begin(); it != m_product_shape_data.end(); )
+		{
+			shared_ptr<IfcObjectDefinition> ifc_object_def = it->second->m_ifc_object_definition.lock();
+			if (ifc_object_def && setTagsToUpdate.find(ifc_object_def->m_tag) != setTagsToUpdate.end())
+			{
+				it = m_product_shape_data.erase(it);
+				continue;
+			}
+			++it;
+		}
+
+		for (auto& update_task : vecUpdatedProducts)
+		{
+			if (update_task.second)
+			{
+				m_product_shape_data[update_task.second->m_entity_guid] = update_task.second;
+			}
+		}
+
+		// rebuild the spatial structure, since parents refer to the replaced ProductShapeData
+		shared_ptr<ProductShapeData> ifcProjectData;
+		for (auto& it_product_shape : m_product_shape_data)
+		{
+			shared_ptr<ProductShapeData>& product_shape = it_product_shape.second;
+			product_shape->clearChildProducts();
+
+			shared_ptr<IfcObjectDefinition> ifc_object_def = product_shape->m_ifc_object_definition.lock();
+			if (ifc_object_def && ifc_object_def->classID() == IFCPROJECT)
+			{
+				ifcProjectData = product_shape;
+			}
+		}
+		m_setResolvedProjectStructure.clear();
+		m_map_outside_spatial_structure.clear();
+		m_spatial_structure_tree.reset();
+		resolveSpatialStructure(ifcProjectData);
+
+		m_representation_converter->clearCache();
+		carve::mesh::release_cached_blocks();
+		progressTextCallback("Updating geometry done");
+		progressValueCallback(1.0, "geometry");
+	}
+
+	//\brief resolveSpatialStructure: attaches the products to their spatial parents (IfcBuilding->IfcBuildingStorey->IfcBuildingElement), collects products outside the spatial structure and creates the GUID tree
+	void resolveSpatialStructure(shared_ptr<ProductShapeData>& ifcProjectData)
+	{
 		try
 		{
 			// now resolve spatial structure
@@ -923,9 +1337,11 @@ public:
 			messageCallback("undefined error", StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__);
 		}
 
-		m_representation_converter->clearCache();
-		progressTextCallback("Loading file done");
-		progressValueCallback(1.0, "geometry");
+		if (ifcProjectData)
+		{
+			std::unordered_set<ProductShapeData*> set_visited;
+			m_spatial_structure_tree = createStructureNode(ifcProjectData, set_visited);
+		}
 	}
 
 	void getAllObjectDefinitions(std::vector<shared_ptr<IfcObjectDefinition> >& vecObjectDefinitions, shared_ptr<ProductShapeData>& ifcProjectData)
@@ -1074,6 +1490,11 @@ public:
 		int productTag = ifc_product->m_tag;
 		printToDebugLog(__FUNC__, "converting element " + std::to_string(productTag));
 
+		if (m_track_dependencies)
+		{
+			collectGeometryDependencies(ifc_product, product_shape->m_dependencies);
+		}
+
 		std::vector<weak_ptr<IfcRelVoidsElement> > vec_rel_voids;
 		shared_ptr<IfcElement> ifc_element = dynamic_pointer_cast<IfcElement>(ifc_product);
 		if (ifc_element)
@@ -1087,31 +1508,51 @@ public:
 			// TODO: cache items
 		}
 
-		// convert IFC geometry
+		// convert IFC geometry. Representations are independent of each other, so they are converted as sub-tasks on the shared thread pool.
+		// Results are added to the product afterwards in the original order, so that the output does not depend on scheduling
 		std::vector<shared_ptr<IfcRepresentation> >& vec_representations = product_representation->m_Representations;
-		for (size_t i_representations = 0; i_representations < vec_representations.size(); ++i_representations)
+		std::vector<std::pair<shared_ptr<IfcRepresentation>, shared_ptr<ItemShapeData> > > vec_representation_data;
+		for (const shared_ptr<IfcRepresentation>& representation : vec_representations)
 		{
-			const shared_ptr<IfcRepresentation>& representation = vec_representations[i_representations];
-			if (!representation)
+			if (representation)
 			{
-				continue;
+				vec_representation_data.push_back({ representation, shared_ptr<ItemShapeData>() });
 			}
+		}
 
+		m_representation_converter->getTaskScheduler()->parallelForEach(vec_representation_data.begin(), vec_representation_data.end(), [&](std::pair<shared_ptr<IfcRepresentation>, shared_ptr<ItemShapeData> >& representation_task) {
+			const shared_ptr<IfcRepresentation>& representation = representation_task.first;
 			try
 			{
 				shared_ptr<ItemShapeData> representation_data(new ItemShapeData());
 				representation_data->m_product = product_shape;
 				bool clearIfcItems = false;
 				m_representation_converter->convertIfcRepresentation(representation, representation_data, clearIfcItems);
-				product_shape->addGeometricItem(representation_data, product_shape);
+				representation_task.second = representation_data;
 			}
 			catch (BuildingException& e)
 			{
-				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "");
+				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", representation.get());
+			}
+			catch (carve::exception& e)
+			{
+				messageCallback(e.str(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, representation.get());
 			}
 			catch (std::exception& e)
 			{
-				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "");
+				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", representation.get());
+			}
+			catch (...)
+			{
+				messageCallback("undefined error", StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, representation.get());
+			}
+		});
+
+		for (auto& representation_task : vec_representation_data)
+		{
+			if (representation_task.second)
+			{
+				product_shape->addGeometricItem(representation_task.second, product_shape);
 			}
 		}
 
@@ -1241,18 +1682,467 @@ public:
 		}
 	}
 
+	/*\brief collectGeometryDependencies: Collects the tags of all entities that the geometry of the product is created from: placements (including relative placements),
+	* representations with their items, profiles, curves and mapped representations, and the openings of the product and of its relating element
+	**/
+	static void collectGeometryDependencies(const shared_ptr<IfcProduct>& ifc_product, std::vector<int>& dependencies)
+	{
+		std::unordered_set<BuildingObject*> set_visited;
+		std::unordered_set<int> set_tags;
+		collectGeometryDependencies(ifc_product->m_ObjectPlacement, set_visited, set_tags);
+		collectGeometryDependencies(ifc_product->m_Representation, set_visited, set_tags);
+
+		std::vector<shared_ptr<IfcElement> > vec_elements_with_openings;
+		shared_ptr<IfcElement> ifc_element = dynamic_pointer_cast<IfcElement>(ifc_product);
+		if (ifc_element)
+		{
+			vec_elements_with_openings.push_back(ifc_element);
+		}
+		for (const weak_ptr<IfcRelAggregates>& rel_aggregates_weak : ifc_product->m_Decomposes_inverse)
+		{
+			shared_ptr<IfcRelAggregates> rel_aggregates = rel_aggregates_weak.lock();
+			if (rel_aggregates)
+			{
+				shared_ptr<IfcElement> relating_element = dynamic_pointer_cast<IfcElement>(rel_aggregates->m_RelatingObject);
+				if (relating_element)
+				{
+					vec_elements_with_openings.push_back(relating_element);
+				}
+			}
+		}
+
+		for (const shared_ptr<IfcElement>& element : vec_elements_with_openings)
+		{
+			// openings that are added to the element later are detected by the tag of the element
+			set_tags.insert(element->m_tag);
+
+			for (const weak_ptr<IfcRelVoidsElement>& rel_voids_weak : element->m_HasOpenings_inverse)
+			{
+				shared_ptr<IfcRelVoidsElement> rel_voids = rel_voids_weak.lock();
+				if (!rel_voids)
+				{
+					continue;
+				}
+				set_tags.insert(rel_voids->m_tag);
+
+				const shared_ptr<IfcFeatureElementSubtraction>& opening = rel_voids->m_RelatedOpeningElement;
+				if (opening)
+				{
+					set_tags.insert(opening->m_tag);
+					collectGeometryDependencies(opening->m_ObjectPlacement, set_visited, set_tags);
+					collectGeometryDependencies(opening->m_Representation, set_visited, set_tags);
+				}
+			}
+		}
+
+		// assigned materials, with their styled representations
+		for (const weak_ptr<IfcRelAssociates>& rel_associates_weak : ifc_product->m_HasAssociations_inverse)
+		{
+			shared_ptr<IfcRelAssociatesMaterial> rel_associates_material = dynamic_pointer_cast<IfcRelAssociatesMaterial>(rel_associates_weak.lock());
+			if (rel_associates_material)
+			{
+				set_tags.insert(rel_associates_material->m_tag);
+				collectGeometryDependencies(rel_associates_material->m_RelatingMaterial, set_visited, set_tags);
+			}
+		}
+
+		dependencies.assign(set_tags.begin(), set_tags.end());
+		std::sort(dependencies.begin(), dependencies.end());
+	}
+
+	//\brief collectRelatedObjectTags: If the entity is an opening relationship, a styled item or a material association, inserts the tags of the objects it is assigned to
+	static void collectRelatedObjectTags(const shared_ptr<BuildingEntity>& entity, std::unordered_set<int>& set_tags)
+	{
+		shared_ptr<IfcRelVoidsElement> rel_voids = dynamic_pointer_cast<IfcRelVoidsElement>(entity);
+		if (rel_voids)
+		{
+			if (rel_voids->m_RelatingBuildingElement)
+			{
+				set_tags.insert(rel_voids->m_RelatingBuildingElement->m_tag);
+			}
+			return;
+		}
+
+		shared_ptr<IfcStyledItem> styled_item = dynamic_pointer_cast<IfcStyledItem>(entity);
+		if (styled_item)
+		{
+			if (styled_item->m_Item)
+			{
+				set_tags.insert(styled_item->m_Item->m_tag);
+			}
+			return;
+		}
+
+		shared_ptr<IfcRelAssociatesMaterial> rel_associates_material = dynamic_pointer_cast<IfcRelAssociatesMaterial>(entity);
+		if (rel_associates_material)
+		{
+			for (const shared_ptr<IfcDefinitionSelect>& related_object : rel_associates_material->m_RelatedObjects)
+			{
+				shared_ptr<BuildingEntity> related_entity = dynamic_pointer_cast<BuildingEntity>(related_object);
+				if (related_entity)
+				{
+					set_tags.insert(related_entity->m_tag);
+				}
+			}
+		}
+	}
+
+	static void collectGeometryDependencies(const shared_ptr<BuildingObject>& obj, std::unordered_set<BuildingObject*>& set_visited, std::unordered_set<int>& set_tags)
+	{
+		if (!obj)
+		{
+			return;
+		}
+
+		// attribute vectors are temporary objects created by getAttributes, so their addresses are reused and must not be added to set_visited
+		shared_ptr<AttributeObjectVector> attribute_object_vector = dynamic_pointer_cast<AttributeObjectVector>(obj);
+		if (attribute_object_vector)
+		{
+			for (const shared_ptr<BuildingObject>& attribute_object : attribute_object_vector->m_vec)
+			{
+				collectGeometryDependencies(attribute_object, set_visited, set_tags);
+			}
+			return;
+		}
+
+		shared_ptr<BuildingEntity> entity = dynamic_pointer_cast<BuildingEntity>(obj);
+		if (!entity)
+		{
+			return;
+		}
+		if (!set_visited.insert(obj.get()).second)
+		{
+			return;
+		}
+		set_tags.insert(entity->m_tag);
+
+		if (dynamic_pointer_cast<IfcRoot>(entity) || dynamic_pointer_cast<IfcOwnerHistory>(entity))
+		{
+			// other products and relationships are tracked separately
+			return;
+		}
+
+		// styles and material representations are referenced only through inverse attributes
+		shared_ptr<IfcRepresentationItem> representation_item = dynamic_pointer_cast<IfcRepresentationItem>(entity);
+		if (representation_item)
+		{
+			for (const weak_ptr<IfcStyledItem>& styled_item_weak : representation_item->m_StyledByItem_inverse)
+			{
+				collectGeometryDependencies(styled_item_weak.lock(), set_visited, set_tags);
+			}
+		}
+
+		shared_ptr<IfcMaterial> material = dynamic_pointer_cast<IfcMaterial>(entity);
+		if (material)
+		{
+			for (const weak_ptr<IfcMaterialDefinitionRepresentation>& material_representation_weak : material->m_HasRepresentation_inverse)
+			{
+				collectGeometryDependencies(material_representation_weak.lock(), set_visited, set_tags);
+			}
+		}
+
+		std::vector<std::pair<std::string, shared_ptr<BuildingObject> > > vec_attributes;
+		entity->getAttributes(vec_attributes);
+		for (const auto& attribute : vec_attributes)
+		{
+			collectGeometryDependencies(attribute.second, set_visited, set_tags);
+		}
+	}
+
+	//\brief dependsOnOpeningsOfRelatingElement: true if the object is aggregated in an element with openings. Those openings are subtracted from the object only after all products are converted
+	static bool dependsOnOpeningsOfRelatingElement(const shared_ptr<IfcObjectDefinition>& object_def)
+	{
+		for (const weak_ptr<IfcRelAggregates>& rel_aggregates_weak : object_def->m_Decomposes_inverse)
+		{
+			if (rel_aggregates_weak.expired())
+			{
+				continue;
+			}
+			shared_ptr<IfcRelAggregates> rel_aggregates(rel_aggregates_weak);
+			shared_ptr<IfcElement> relating_element = dynamic_pointer_cast<IfcElement>(rel_aggregates->m_RelatingObject);
+			if (relating_element)
+			{
+				if (relating_element->m_HasOpenings_inverse.size() > 0)
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void sendElementConverted(shared_ptr<ProductShapeData>& product_shape)
+	{
+		finalizeProductShape(product_shape);
+
+		std::lock_guard<std::mutex> lock(m_writelock_element_converted);
+		try
+		{
+			elementConvertedCallbackHandler(product_shape);
+		}
+		catch (std::exception& e)
+		{
+			messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__);
+		}
+		catch (...)
+		{
+			messageCallback("undefined error in ElementConvertedCallback", StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__);
+		}
+	}
+
+	//\brief finalizeProductShape: called once per product after all openings are subtracted. Creates the levels of detail and finalized meshes, if enabled in the settings
+	void finalizeProductShape(shared_ptr<ProductShapeData>& product_shape)
+	{
+		createLevelsOfDetail(product_shape);
+
+		if (!product_shape || !m_geom_settings->isCreateFinalizedMeshes())
+		{
+			return;
+		}
+
+		const double crease_angle = m_geom_settings->getFinalizedMeshCreaseAngle();
+		const bool release_half_edge_meshes = m_geom_settings->isReleaseHalfEdgeMeshes();
+		const int product_style_id = MeshFinalizer::getSurfaceStyleId(product_shape->getStyles());
+		for (const shared_ptr<ItemShapeData>& item : product_shape->getGeometricItems())
+		{
+			MeshFinalizer::finalizeItem(item, crease_angle, release_half_edge_meshes, product_style_id);
+		}
+		for (const shared_ptr<LevelOfDetailData>& level : product_shape->m_levels_of_detail)
+		{
+			for (const shared_ptr<ItemShapeData>& item : level->m_geometric_items)
+			{
+				MeshFinalizer::finalizeItem(item, crease_angle, release_half_edge_meshes, product_style_id);
+			}
+		}
+	}
+
+	/**\brief createLevelsOfDetail: coarser copies of the product meshes, see GeometrySettings::setLevelsOfDetail.
+	Each level is decimated from the previous one, so the meshes of all levels derive from the same CSG results */
+	void createLevelsOfDetail(shared_ptr<ProductShapeData>& product_shape)
+	{
+		if (!product_shape)
+		{
+			return;
+		}
+		product_shape->m_levels_of_detail.clear();
+
+		const std::vector<double>& levels_of_detail = m_geom_settings->getLevelsOfDetail();
+		if (levels_of_detail.size() == 0 || product_shape->getGeometricItems().size() == 0)
+		{
+			return;
+		}
+
+		shared_ptr<IfcObjectDefinition> ifc_object_def = product_shape->m_ifc_object_definition.lock();
+		GeomProcessingParams params(m_geom_settings, ifc_object_def.get(), this);
+
+		try
+		{
+			const std::vector<shared_ptr<ItemShapeData> >* previous_items = &product_shape->getGeometricItems();
+			for (double min_edge_length : levels_of_detail)
+			{
+				shared_ptr<LevelOfDetailData> level = make_shared<LevelOfDetailData>();
+				level->m_min_edge_length = min_edge_length;
+				for (const shared_ptr<ItemShapeData>& item : *previous_items)
+				{
+					level->m_geometric_items.push_back(createLevelOfDetailItem(item, min_edge_length, params));
+				}
+				product_shape->m_levels_of_detail.push_back(level);
+				previous_items = &level->m_geometric_items;
+			}
+		}
+		catch (carve::exception& e)
+		{
+			messageCallback(e.str(), StatusCallback::MESSAGE_TYPE_WARNING, __FUNC__, ifc_object_def.get());
+		}
+		catch (std::exception& e)
+		{
+			messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_WARNING, __FUNC__, ifc_object_def.get());
+		}
+	}
+
+	static shared_ptr<ItemShapeData> createLevelOfDetailItem(const shared_ptr<ItemShapeData>& item, double min_edge_length, const GeomProcessingParams& params)
+	{
+		shared_ptr<ItemShapeData> lod_item = make_shared<ItemShapeData>();
+		lod_item->m_product = item->m_product;
+		lod_item->m_ifc_representation = item->m_ifc_representation;
+		lod_item->m_styles = item->m_styles;
+
+		for (const shared_ptr<carve::mesh::MeshSet<3> >& meshset : item->m_meshsets)
+		{
+			lod_item->m_meshsets.push_back(MeshSimplifier::decimateMeshSet(meshset, min_edge_length, params));
+		}
+		for (const shared_ptr<carve::mesh::MeshSet<3> >& meshset : item->m_meshsets_open)
+		{
+			lod_item->m_meshsets_open.push_back(MeshSimplifier::decimateMeshSet(meshset, min_edge_length, params));
+		}
+		for (const shared_ptr<ItemShapeData>& child_item : item->m_child_items)
+		{
+			shared_ptr<ItemShapeData> lod_child = createLevelOfDetailItem(child_item, min_edge_length, params);
+			lod_child->m_parentItem = lod_item;
+			lod_item->m_child_items.push_back(lod_child);
+		}
+		return lod_item;
+	}
+
+	//\brief createPlaceholderShapeData: ProductShapeData without geometry, with just enough information to resolve the spatial structure
+	static shared_ptr<ProductShapeData> createPlaceholderShapeData(const shared_ptr<ProductShapeData>& product_shape)
+	{
+		shared_ptr<ProductShapeData> placeholder = make_shared<ProductShapeData>(product_shape->m_entity_guid);
+		placeholder->m_ifc_object_definition = product_shape->m_ifc_object_definition;
+		return placeholder;
+	}
+
+	shared_ptr<ProductStructureNode> createStructureNode(const shared_ptr<ProductShapeData>& product_shape, std::unordered_set<ProductShapeData*>& set_visited)
+	{
+		shared_ptr<ProductStructureNode> node = make_shared<ProductStructureNode>();
+		node->guid = product_shape->m_entity_guid;
+		set_visited.insert(product_shape.get());
+		if (!product_shape->m_ifc_object_definition.expired())
+		{
+			shared_ptr<IfcObjectDefinition> ifc_object_def(product_shape->m_ifc_object_definition);
+			node->tag = ifc_object_def->m_tag;
+			node->classID = ifc_object_def->classID();
+		}
+
+		for (const shared_ptr<ProductShapeData>& child_product : product_shape->getChildElements())
+		{
+			if (child_product && set_visited.find(child_product.get()) == set_visited.end())
+			{
+				node->children.push_back(createStructureNode(child_product, set_visited));
+			}
+		}
+		return node;
+	}
+
 	void sendProgress(double progress)
 	{
+		// products finish in arbitrary order, so check and update under the lock to keep the reported progress monotonic
+		std::lock_guard<std::mutex> lock(m_writelock_progress);
 		if (progress - m_recent_progress > 0.01)
 		{
-			std::lock_guard<std::mutex> lock(m_writelock_progress);
-
 			// leave 20% of progress to openings, rendering, file export etc
 			progressValueCallback(progress * 0.8, "geometry");
 			m_recent_progress = progress;
 		}
 	}
 
+	/*\brief estimateConversionCost: rough estimate of the effort to convert the geometry of an object, used to schedule expensive products first.
+	* Counts representation items (also inside mapped items), faces of boundary representations and tessellations, and weights boolean operations and openings
+	**/
+	static size_t estimateConversionCost(const shared_ptr<IfcObjectDefinition>& object_def)
+	{
+		shared_ptr<IfcProduct> ifc_product = dynamic_pointer_cast<IfcProduct>(object_def);
+		if (!ifc_product)
+		{
+			return 0;
+		}
+
+		size_t cost = 0;
+		if (ifc_product->m_Representation)
+		{
+			for (const shared_ptr<IfcRepresentation>& representation : ifc_product->m_Representation->m_Representations)
+			{
+				cost += estimateConversionCost(representation, 0);
+			}
+		}
+
+		shared_ptr<IfcElement> ifc_element = dynamic_pointer_cast<IfcElement>(ifc_product);
+		if (ifc_element)
+		{
+			// each opening is converted itself and then subtracted from each meshset of the product
+			const size_t cost_per_opening = 50;
+			cost += ifc_element->m_HasOpenings_inverse.size() * (cost_per_opening + cost);
+		}
+		return cost;
+	}
+
+	static size_t estimateConversionCost(const shared_ptr<IfcRepresentation>& representation, int recursionDepth)
+	{
+		if (!representation || recursionDepth > 10)
+		{
+			return 0;
+		}
+
+		const size_t cost_per_item = 10;
+		const size_t cost_per_boolean_operation = 200;
+		size_t cost = 0;
+		for (const shared_ptr<IfcRepresentationItem>& item : representation->m_Items)
+		{
+			if (!item)
+			{
+				continue;
+			}
+			cost += cost_per_item;
+
+			shared_ptr<IfcMappedItem> mapped_item = dynamic_pointer_cast<IfcMappedItem>(item);
+			if (mapped_item)
+			{
+				if (mapped_item->m_MappingSource)
+				{
+					cost += estimateConversionCost(mapped_item->m_MappingSource->m_MappedRepresentation, recursionDepth + 1);
+				}
+				continue;
+			}
+
+			if (dynamic_pointer_cast<IfcBooleanResult>(item))
+			{
+				cost += cost_per_boolean_operation;
+				continue;
+			}
+
+			shared_ptr<IfcManifoldSolidBrep> brep = dynamic_pointer_cast<IfcManifoldSolidBrep>(item);
+			if (brep)
+			{
+				if (brep->m_Outer)
+				{
+					cost += brep->m_Outer->m_CfsFaces.size();
+				}
+				continue;
+			}
+
+			shared_ptr<IfcFaceBasedSurfaceModel> face_based_model = dynamic_pointer_cast<IfcFaceBasedSurfaceModel>(item);
+			if (face_based_model)
+			{
+				for (const shared_ptr<IfcConnectedFaceSet>& face_set : face_based_model->m_FbsmFaces)
+				{
+					if (face_set)
+					{
+						cost += face_set->m_CfsFaces.size();
+					}
+				}
+				continue;
+			}
+
+			shared_ptr<IfcShellBasedSurfaceModel> shell_based_model = dynamic_pointer_cast<IfcShellBasedSurfaceModel>(item);
+			if (shell_based_model)
+			{
+				for (const shared_ptr<IfcShell>& shell : shell_based_model->m_SbsmBoundary)
+				{
+					shared_ptr<IfcConnectedFaceSet> face_set = dynamic_pointer_cast<IfcConnectedFaceSet>(shell);
+					if (face_set)
+					{
+						cost += face_set->m_CfsFaces.size();
+					}
+				}
+				continue;
+			}
+
+			shared_ptr<IfcPolygonalFaceSet> polygonal_face_set = dynamic_pointer_cast<IfcPolygonalFaceSet>(item);
+			if (polygonal_face_set)
+			{
+				cost += polygonal_face_set->m_Faces.size();
+				continue;
+			}
+
+			shared_ptr<IfcTriangulatedFaceSet> triangulated_face_set = dynamic_pointer_cast<IfcTriangulatedFaceSet>(item);
+			if (triangulated_face_set)
+			{
+				cost += triangulated_face_set->m_CoordIndex.size();
+			}
+		}
+		return cost;
+	}
+
 	virtual void messageTarget(void* ptr, shared_ptr<StatusCallback::Message> m)
 	{
 		GeometryConverter* myself = (GeometryConverter*)ptr;
@@ -142,6 +142,69 @@ public:
 	carve::math::Matrix m_text_position;
 };
 
+/**\brief FinalizedMeshData: compact indexed triangle mesh of an item, in the same coordinate system as the meshsets of the item. Flat arrays that can be copied
+directly into vertex and index buffers. Created by MeshFinalizer, see GeometrySettings::setCreateFinalizedMeshes */
+class FinalizedMeshData
+{
+public:
+	std::vector<float>		m_positions;			// x, y, z per vertex. Single precision is sufficient, since the meshes are in the local coordinate system of the product
+	std::vector<float>		m_normals;				// x, y, z per vertex, normalized
+	std::vector<uint32_t>	m_indices;				// three per triangle, counter-clockwise seen from outside
+	std::vector<int>		m_triangle_style_ids;	// StyleData::m_step_style_id per triangle, -1 if not styled
+
+	size_t getNumVertices() const { return m_positions.size() / 3; }
+	size_t getNumTriangles() const { return m_indices.size() / 3; }
+	size_t getMemoryUsage() const
+	{
+		return m_positions.capacity() * sizeof(float) + m_normals.capacity() * sizeof(float) + m_indices.capacity() * sizeof(uint32_t) + m_triangle_style_ids.capacity() * sizeof(int);
+	}
+
+	//\brief applyTransform: transforms positions and normals. If the matrix changes handedness, the triangles are flipped to stay counter-clockwise from outside
+	void applyTransform(const carve::math::Matrix& mat, bool invert_triangles)
+	{
+		for (size_t i = 0; i + 2 < m_positions.size(); i += 3)
+		{
+			vec3 point = mat * carve::geom::VECTOR(m_positions[i], m_positions[i + 1], m_positions[i + 2]);
+			m_positions[i] = (float)point.x;
+			m_positions[i + 1] = (float)point.y;
+			m_positions[i + 2] = (float)point.z;
+		}
+
+		// normals are transformed with the cofactor matrix of the linear part, which is the inverse transpose scaled by the determinant
+		const vec3 c0 = carve::geom::VECTOR(mat.m[0][0], mat.m[0][1], mat.m[0][2]);
+		const vec3 c1 = carve::geom::VECTOR(mat.m[1][0], mat.m[1][1], mat.m[1][2]);
+		const vec3 c2 = carve::geom::VECTOR(mat.m[2][0], mat.m[2][1], mat.m[2][2]);
+		const vec3 cof0 = carve::geom::cross(c1, c2);
+		const vec3 cof1 = carve::geom::cross(c2, c0);
+		const vec3 cof2 = carve::geom::cross(c0, c1);
+		for (size_t i = 0; i + 2 < m_normals.size(); i += 3)
+		{
+			vec3 normal = cof0 * m_normals[i] + cof1 * m_normals[i + 1] + cof2 * m_normals[i + 2];
+			double length = normal.length();
+			if (length > 0)
+			{
+				normal /= length;
+			}
+			if (invert_triangles)
+			{
+				// negative determinant: the cofactor matrix points the normal to the inside
+				normal = -normal;
+			}
+			m_normals[i] = (float)normal.x;
+			m_normals[i + 1] = (float)normal.y;
+			m_normals[i + 2] = (float)normal.z;
+		}
+
+		if (invert_triangles)
+		{
+			for (size_t i = 0; i + 2 < m_indices.size(); i += 3)
+			{
+				std::swap(m_indices[i + 1], m_indices[i + 2]);
+			}
+		}
+	}
+};
+
 inline void premultMatrix( const carve::math::Matrix& matrix_to_append, carve::math::Matrix& target_matrix )
 {
 	target_matrix = matrix_to_append*target_matrix;
@@ -319,10 +382,12 @@ public:
 	std::vector<shared_ptr<TextItemData> >					m_text_literals;
 	std::vector<shared_ptr<carve::input::VertexData> >		m_vertex_points;
 	std::vector<shared_ptr<StyleData> >						m_styles;
+	shared_ptr<FinalizedMeshData>							m_finalized_mesh;	// triangles of m_meshsets and m_meshsets_open, if GeometrySettings::setCreateFinalizedMeshes is set
 	
 	const std::vector<shared_ptr<StyleData> >& getStyles() { return m_styles; }
 	bool isItemShapeEmpty()
 	{
+		if (m_finalized_mesh && m_finalized_mesh->getNumTriangles() > 0) { return false; }
 		if (m_vertex_points.size() > 0) { return false; }
 		if (m_polylines.size() > 0) { return false; }
 		if (m_meshsets.size() > 0) { return false; }
@@ -353,6 +418,11 @@ public:
 		m_text_literals = other->m_text_literals;
 		m_vertex_points = other->m_vertex_points;
 		m_styles = other->m_styles;
+		m_finalized_mesh.reset();
+		if (other->m_finalized_mesh)
+		{
+			m_finalized_mesh = make_shared<FinalizedMeshData>(*other->m_finalized_mesh);
+		}
 	}
 
 	void addOpenOrClosedPolyhedron(const shared_ptr<carve::input::PolyhedronData>& poly_data, const GeomProcessingParams& params);
@@ -438,6 +508,7 @@ public:
 	{
 		m_meshsets.clear();
 		m_meshsets_open.clear();
+		m_finalized_mesh.reset();
 		m_text_literals.clear();
 		m_styles.clear();
 		m_vertex_points.clear();
@@ -455,6 +526,83 @@ public:
 		m_ifc_representation.reset();
 	}
 
+	static void applyTransformToMeshSet(const shared_ptr<carve::mesh::MeshSet<3> >& item_meshset, const carve::math::Matrix& mat, double eps, bool invert_meshes, bool closed_meshset)
+	{
+		if (!item_meshset)
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < item_meshset->vertex_storage.size(); ++i)
+		{
+			vec3& point = item_meshset->vertex_storage[i].v;
+			point = mat * point;
+		}
+		for (size_t i = 0; i < item_meshset->meshes.size(); ++i)
+		{
+			item_meshset->meshes[i]->recalc(eps);
+			if (invert_meshes)
+			{
+				item_meshset->meshes[i]->invert();
+				if (closed_meshset)
+				{
+					//calcOrientation resets isNegative flag (usually)
+					item_meshset->meshes[i]->calcOrientation();
+				}
+			}
+		}
+		item_meshset->refitFaceTree();
+	}
+
+	/**\brief applyTransformToMeshSets: transforms only the meshsets of this item and its children, skipping meshsets in setTransformed. Used for levels of detail,
+	which contain only meshes and can share them with other levels */
+	void applyTransformToMeshSets(const carve::math::Matrix& mat, double eps, std::unordered_set<const carve::mesh::MeshSet<3>*>& setTransformed)
+	{
+		bool const invert_meshes = 0 > carve::geom::dotcross(
+			carve::geom::VECTOR(mat.m[0][0], mat.m[1][0], mat.m[2][0]),
+			carve::geom::VECTOR(mat.m[0][1], mat.m[1][1], mat.m[2][1]),
+			carve::geom::VECTOR(mat.m[0][2], mat.m[1][2], mat.m[2][2]));
+
+		for (const shared_ptr<carve::mesh::MeshSet<3> >& item_meshset : m_meshsets_open)
+		{
+			if (item_meshset && setTransformed.insert(item_meshset.get()).second)
+			{
+				applyTransformToMeshSet(item_meshset, mat, eps, invert_meshes, false);
+			}
+		}
+		for (const shared_ptr<carve::mesh::MeshSet<3> >& item_meshset : m_meshsets)
+		{
+			if (item_meshset && setTransformed.insert(item_meshset.get()).second)
+			{
+				applyTransformToMeshSet(item_meshset, mat, eps, invert_meshes, true);
+			}
+		}
+		if (m_finalized_mesh)
+		{
+			m_finalized_mesh->applyTransform(mat, invert_meshes);
+		}
+		for (auto child : m_child_items)
+		{
+			child->applyTransformToMeshSets(mat, eps, setTransformed);
+		}
+	}
+
+	void collectMeshSets(std::unordered_set<const carve::mesh::MeshSet<3>*>& setMeshSets) const
+	{
+		for (const shared_ptr<carve::mesh::MeshSet<3> >& item_meshset : m_meshsets_open)
+		{
+			setMeshSets.insert(item_meshset.get());
+		}
+		for (const shared_ptr<carve::mesh::MeshSet<3> >& item_meshset : m_meshsets)
+		{
+			setMeshSets.insert(item_meshset.get());
+		}
+		for (auto child : m_child_items)
+		{
+			child->collectMeshSets(setMeshSets);
+		}
+	}
+
 	void applyTransformToItem(const carve::math::Matrix& mat, double eps, bool matrix_identity_checked)
 	{
 		if (!matrix_identity_checked)
@@ -494,50 +642,17 @@ public:
 
 		for (size_t i_meshsets = 0; i_meshsets < m_meshsets_open.size(); ++i_meshsets)
 		{
-			shared_ptr<carve::mesh::MeshSet<3> >& item_meshset = m_meshsets_open[i_meshsets];
-			if (!item_meshset)
-			{
-				continue;
-			}
-
-			for (size_t i = 0; i < item_meshset->vertex_storage.size(); ++i)
-			{
-				vec3& point = item_meshset->vertex_storage[i].v;
-				point = mat * point;
-			}
-			for (size_t i = 0; i < item_meshset->meshes.size(); ++i)
-			{
-				item_meshset->meshes[i]->recalc(eps);
-				if (invert_meshes)
-				{
-					item_meshset->meshes[i]->invert();
-				}
-			}
+			applyTransformToMeshSet(m_meshsets_open[i_meshsets], mat, eps, invert_meshes, false);
 		}
 
 		for (size_t i_meshsets = 0; i_meshsets < m_meshsets.size(); ++i_meshsets)
 		{
-			shared_ptr<carve::mesh::MeshSet<3> >& item_meshset = m_meshsets[i_meshsets];
-			if (!item_meshset)
-			{
-				continue;
-			}
+			applyTransformToMeshSet(m_meshsets[i_meshsets], mat, eps, invert_meshes, true);
+		}
 
-			for (size_t i = 0; i < item_meshset->vertex_storage.size(); ++i)
-			{
-				vec3& point = item_meshset->vertex_storage[i].v;
-				point = mat * point;
-			}
-			for (size_t i = 0; i < item_meshset->meshes.size(); ++i)
-			{
-				item_meshset->meshes[i]->recalc(eps);
-				if (invert_meshes)
-				{
-					item_meshset->meshes[i]->invert();
-					//calcOrientation resets isNegative flag (usually)
-					item_meshset->meshes[i]->calcOrientation();
-				}
-			}
+		if (m_finalized_mesh)
+		{
+			m_finalized_mesh->applyTransform(mat, invert_meshes);
 		}
 
 		for (size_t text_i = 0; text_i < m_text_literals.size(); ++text_i)
@@ -707,6 +822,7 @@ public:
 	{
 		if (m_meshsets.size() > 0) return true;
 		if (m_meshsets_open.size() > 0) return true;
+		if (m_finalized_mesh && m_finalized_mesh->getNumTriangles() > 0) return true;
 		if (includeLinesPointsAndText)
 		{
 			if (m_text_literals.size() > 0) return true;
@@ -764,6 +880,14 @@ public:
 *                           |-> ProductShapeData [1...n]            representation
 *                                     |-> ProductShapeData [1...n]       geometric item
 */
+//\brief LevelOfDetailData: coarser version of the geometric items of a product, see GeometrySettings::setLevelsOfDetail
+class LevelOfDetailData
+{
+public:
+	double											m_min_edge_length = 0;	// edges shorter than this have been collapsed
+	std::vector<shared_ptr<ItemShapeData> >			m_geometric_items;		// same order and styles as ProductShapeData::getGeometricItems, but only meshes. Meshes that could not be decimated are shared with the full detail items
+};
+
 class ProductShapeData 
 {
 protected:
@@ -779,6 +903,8 @@ public:
 	
 	weak_ptr<ProductShapeData>						m_parent;
 	std::vector<shared_ptr<TransformData> >			m_transforms;
+	std::vector<int>								m_dependencies;		// sorted tags of the IFC entities that the geometry is created from, see GeometryConverter::m_track_dependencies
+	std::vector<shared_ptr<LevelOfDetailData> >		m_levels_of_detail;	// coarser levels in the order of GeometrySettings::getLevelsOfDetail. The full detail is in getGeometricItems
 
 	ProductShapeData() {}
 	ProductShapeData( std::string entity_guid ) : m_entity_guid(entity_guid) { }
@@ -787,6 +913,12 @@ public:
 	const std::vector<shared_ptr<ItemShapeData> >& getGeometricItems() { return m_geometric_items; }
 	const std::vector<shared_ptr<StyleData> >& getStyles() { return m_styles; }
 	void clearGeometricChildItems() { m_geometric_items.clear(); }
+	void clearChildProducts()
+	{
+		m_child_products.clear();
+		m_added_to_spatial_structure = false;
+		m_parent.reset();
+	}
 
 	void addGeometricItem(shared_ptr<ItemShapeData>& item, const shared_ptr<ProductShapeData>& ptr_self)
 	{
@@ -825,6 +957,7 @@ public:
 	{
 		m_styles.clear();
 		m_object_placement.reset();
+		m_levels_of_detail.clear();
 		
 		for( size_t item_i = 0; item_i < m_geometric_items.size(); ++item_i )
 		{
@@ -1027,6 +1160,23 @@ public:
 			m_geometric_items[i_item]->applyTransformToItem( matrix, eps, true );
 		}
 
+		if( m_levels_of_detail.size() > 0 )
+		{
+			// meshes that could not be decimated are shared with the full detail items or other levels, and must be transformed only once
+			std::unordered_set<const carve::mesh::MeshSet<3>*> setTransformed;
+			for( const shared_ptr<ItemShapeData>& item : m_geometric_items )
+			{
+				item->collectMeshSets( setTransformed );
+			}
+			for( const shared_ptr<LevelOfDetailData>& level : m_levels_of_detail )
+			{
+				for( const shared_ptr<ItemShapeData>& item : level->m_geometric_items )
+				{
+					item->applyTransformToMeshSets( matrix, eps, setTransformed );
+				}
+			}
+		}
+
 		if( applyToChildren )
 		{
 			for( auto child_product_data : m_child_products)
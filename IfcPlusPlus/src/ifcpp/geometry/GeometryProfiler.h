@@ -0,0 +1,330 @@
+/* -*-c++-*- IfcQuery www.ifcquery.com
+*
+MIT License
+
+Copyright (c) 2017 Fabian Gerold
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <ifcpp/IFC4X3/EntityFactory.h>
+
+/**\brief GeometryProfiler: collects timing and CSG statistics of one geometry conversion run.
+The profiler is attached to GeometrySettings::m_profiler. If that pointer is null (the default), every instrumentation point reduces to a single pointer check.
+Product and item times are inclusive wall times. An IfcMappedItem contains the time of the items of its mapped representation. A product or item that
+waits for its nested tasks runs some of them on its own thread, and the time of those is included. TaskScheduler lets a waiting thread only run tasks nested in
+the batch it waits for, so the time of other products and items is not charged to it. */
+class GeometryProfiler
+{
+public:
+	typedef std::chrono::steady_clock clock_type;
+
+	//\brief ProductEvent: wall time of one IfcObjectDefinition, including its representation items and openings
+	struct ProductEvent
+	{
+		int tag = -1;
+		uint32_t classID = 0;
+		std::string guid;
+		size_t thread_index = 0;
+		double start_ms = 0;		// relative to the start of the conversion
+		double duration_ms = 0;
+	};
+
+	//\brief ItemTypeStatistics: accumulated wall time of all representation items of one IFC class
+	struct ItemTypeStatistics
+	{
+		size_t count = 0;
+		double total_ms = 0;
+		double max_ms = 0;
+	};
+
+	//\brief ScopedProductTimer: records a ProductEvent in the destructor. Does nothing if the profiler is null
+	struct ScopedProductTimer
+	{
+		GeometryProfiler* m_profiler;
+		clock_type::time_point m_start;
+		int m_tag;
+		uint32_t m_classID;
+		std::string m_guid;
+
+		ScopedProductTimer(GeometryProfiler* profiler, int tag, uint32_t classID, const std::string& guid) : m_profiler(profiler), m_tag(tag), m_classID(classID), m_guid(guid)
+		{
+			if (m_profiler)
+			{
+				m_start = clock_type::now();
+			}
+		}
+		~ScopedProductTimer()
+		{
+			if (m_profiler)
+			{
+				m_profiler->addProductEvent(m_tag, m_classID, m_guid, m_start, clock_type::now());
+			}
+		}
+	};
+
+	//\brief ScopedItemTimer: adds the wall time of one representation item to the statistics of its class. Does nothing if the profiler is null
+	struct ScopedItemTimer
+	{
+		GeometryProfiler* m_profiler;
+		clock_type::time_point m_start;
+		uint32_t m_classID;
+
+		ScopedItemTimer(GeometryProfiler* profiler, uint32_t classID) : m_profiler(profiler), m_classID(classID)
+		{
+			if (m_profiler)
+			{
+				m_start = clock_type::now();
+			}
+		}
+		~ScopedItemTimer()
+		{
+			if (m_profiler)
+			{
+				m_profiler->addItemTime(m_classID, std::chrono::duration<double, std::milli>(clock_type::now() - m_start).count());
+			}
+		}
+	};
+
+	// CSG statistics. Counters are updated with relaxed atomics, since they are only read after the conversion
+	std::atomic<size_t> m_csg_calls{ 0 };				// boolean operations, one per second operand
+	std::atomic<size_t> m_csg_attempts{ 0 };			// calls of the Carve kernel, including retries
+	std::atomic<size_t> m_csg_retries{ 0 };				// attempts with a further parameter variant after a failed first attempt
+	std::atomic<size_t> m_csg_retried_calls{ 0 };		// operations where the first attempt failed
+	std::atomic<size_t> m_csg_fallbacks{ 0 };			// operations where all variants failed, so that the first operand is used unchanged
+	std::atomic<size_t> m_csg_operand_faces_sum{ 0 };
+	std::atomic<size_t> m_csg_operand_faces_max{ 0 };
+	std::atomic<int64_t> m_csg_time_us{ 0 };
+	std::atomic<size_t> m_profile_cache_hits{ 0 };
+	std::atomic<size_t> m_profile_cache_misses{ 0 };
+
+	GeometryProfiler()
+	{
+		m_time_start = clock_type::now();
+	}
+
+	//\brief reset: clears all events and counters, and sets the time origin of the trace to now
+	void reset()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_time_start = clock_type::now();
+		m_product_events.clear();
+		m_item_statistics.clear();
+		m_thread_index.clear();
+		m_csg_calls = 0;
+		m_csg_attempts = 0;
+		m_csg_retries = 0;
+		m_csg_retried_calls = 0;
+		m_csg_fallbacks = 0;
+		m_csg_operand_faces_sum = 0;
+		m_csg_operand_faces_max = 0;
+		m_csg_time_us = 0;
+		m_profile_cache_hits = 0;
+		m_profile_cache_misses = 0;
+	}
+
+	void addProductEvent(int tag, uint32_t classID, const std::string& guid, clock_type::time_point start, clock_type::time_point end)
+	{
+		ProductEvent ev;
+		ev.tag = tag;
+		ev.classID = classID;
+		ev.guid = guid;
+		ev.duration_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		ev.start_ms = std::chrono::duration<double, std::milli>(start - m_time_start).count();
+		ev.thread_index = getThreadIndex();
+		m_product_events.push_back(ev);
+	}
+
+	//\brief removeProductEvents: removes the events of products that are converted again, see GeometryConverter::updateGeometry
+	void removeProductEvents(const std::unordered_set<int>& tags)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_product_events.erase(std::remove_if(m_product_events.begin(), m_product_events.end(), [&tags](const ProductEvent& ev) { return tags.find(ev.tag) != tags.end(); }), m_product_events.end());
+	}
+
+	void addItemTime(uint32_t classID, double duration_ms)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		ItemTypeStatistics& stat = m_item_statistics[classID];
+		++stat.count;
+		stat.total_ms += duration_ms;
+		stat.max_ms = std::max(stat.max_ms, duration_ms);
+	}
+
+	void addCsgOperandFaces(size_t numFaces)
+	{
+		m_csg_operand_faces_sum.fetch_add(numFaces, std::memory_order_relaxed);
+		size_t previous = m_csg_operand_faces_max.load(std::memory_order_relaxed);
+		while (previous < numFaces && !m_csg_operand_faces_max.compare_exchange_weak(previous, numFaces, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	void addCsgTime(clock_type::duration duration)
+	{
+		m_csg_time_us.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), std::memory_order_relaxed);
+	}
+
+	//\brief getCsgRetryRate: fraction of boolean operations that did not succeed with the first parameter set
+	double getCsgRetryRate() const
+	{
+		size_t calls = m_csg_calls.load();
+		return calls > 0 ? double(m_csg_retried_calls.load()) / double(calls) : 0.0;
+	}
+
+	//\brief getProductEvents: recorded products, sorted by duration (slowest first)
+	std::vector<ProductEvent> getProductEvents()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::vector<ProductEvent> result(m_product_events);
+		std::sort(result.begin(), result.end(), [](const ProductEvent& a, const ProductEvent& b) { return a.duration_ms > b.duration_ms; });
+		return result;
+	}
+
+	std::map<uint32_t, ItemTypeStatistics> getItemStatistics()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return std::map<uint32_t, ItemTypeStatistics>(m_item_statistics.begin(), m_item_statistics.end());
+	}
+
+	//\brief toJSON: summary with CSG and cache counters, per item class statistics and per product times
+	std::string toJSON()
+	{
+		std::vector<ProductEvent> products = getProductEvents();
+		std::map<uint32_t, ItemTypeStatistics> items = getItemStatistics();
+
+		std::stringstream strs;
+		strs << "{\n";
+		strs << "  \"csg\": {";
+		strs << "\"calls\": " << m_csg_calls.load();
+		strs << ", \"attempts\": " << m_csg_attempts.load();
+		strs << ", \"retries\": " << m_csg_retries.load();
+		strs << ", \"retried_calls\": " << m_csg_retried_calls.load();
+		strs << ", \"retry_rate\": " << getCsgRetryRate();
+		strs << ", \"fallbacks\": " << m_csg_fallbacks.load();
+		strs << ", \"operand_faces_sum\": " << m_csg_operand_faces_sum.load();
+		strs << ", \"operand_faces_max\": " << m_csg_operand_faces_max.load();
+		strs << ", \"total_ms\": " << double(m_csg_time_us.load()) * 0.001;
+		strs << "},\n";
+		strs << "  \"profile_cache\": {\"hits\": " << m_profile_cache_hits.load() << ", \"misses\": " << m_profile_cache_misses.load() << "},\n";
+
+		strs << "  \"item_types\": [";
+		bool first = true;
+		for (auto& it : items)
+		{
+			const ItemTypeStatistics& stat = it.second;
+			strs << (first ? "\n" : ",\n");
+			strs << "    {\"type\": \"" << getClassName(it.first) << "\", \"count\": " << stat.count << ", \"total_ms\": " << stat.total_ms << ", \"max_ms\": " << stat.max_ms << "}";
+			first = false;
+		}
+		strs << "\n  ],\n";
+
+		strs << "  \"products\": [";
+		first = true;
+		for (const ProductEvent& ev : products)
+		{
+			strs << (first ? "\n" : ",\n");
+			strs << "    {\"tag\": " << ev.tag << ", \"guid\": \"" << escapeJSON(ev.guid) << "\", \"type\": \"" << getClassName(ev.classID) << "\", \"thread\": " << ev.thread_index;
+			strs << ", \"start_ms\": " << ev.start_ms << ", \"duration_ms\": " << ev.duration_ms << "}";
+			first = false;
+		}
+		strs << "\n  ]\n";
+		strs << "}\n";
+		return strs.str();
+	}
+
+	//\brief toChromeTrace: products as complete events ("ph": "X") in the Trace Event Format, to be loaded in chrome://tracing or ui.perfetto.dev
+	std::string toChromeTrace()
+	{
+		std::vector<ProductEvent> products = getProductEvents();
+		std::sort(products.begin(), products.end(), [](const ProductEvent& a, const ProductEvent& b) { return a.start_ms < b.start_ms; });
+
+		std::stringstream strs;
+		strs.setf(std::ios::fixed);
+		strs.precision(3);
+		strs << "{\"traceEvents\": [";
+		bool first = true;
+		for (const ProductEvent& ev : products)
+		{
+			strs << (first ? "\n" : ",\n");
+			strs << "{\"name\": \"" << getClassName(ev.classID) << " #" << ev.tag << "\", \"cat\": \"product\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << ev.thread_index;
+			strs << ", \"ts\": " << ev.start_ms * 1000.0 << ", \"dur\": " << ev.duration_ms * 1000.0;
+			strs << ", \"args\": {\"guid\": \"" << escapeJSON(ev.guid) << "\"}}";
+			first = false;
+		}
+		strs << "\n], \"displayTimeUnit\": \"ms\"}\n";
+		return strs.str();
+	}
+
+protected:
+	std::mutex m_mutex;
+	clock_type::time_point m_time_start;
+	std::vector<ProductEvent> m_product_events;
+	std::unordered_map<uint32_t, ItemTypeStatistics> m_item_statistics;
+	std::unordered_map<std::thread::id, size_t> m_thread_index;
+
+	// small consecutive thread numbers are easier to read in trace viewers than hashed thread ids. Caller holds m_mutex
+	size_t getThreadIndex()
+	{
+		auto it = m_thread_index.find(std::this_thread::get_id());
+		if (it != m_thread_index.end())
+		{
+			return it->second;
+		}
+		size_t index = m_thread_index.size() + 1;
+		m_thread_index[std::this_thread::get_id()] = index;
+		return index;
+	}
+
+	static std::string getClassName(uint32_t classID)
+	{
+		const char* name = IFC4X3::EntityFactory::getStringForClassID(classID);
+		return name ? std::string(name) : std::to_string(classID);
+	}
+
+	static std::string escapeJSON(const std::string& str)
+	{
+		std::string result;
+		result.reserve(str.size());
+		for (char c : str)
+		{
+			if (c == '"' || c == '\\')
+			{
+				result += '\\';
+				result += c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20)
+			{
+				result += ' ';
+			}
+			else
+			{
+				result += c;
+			}
+		}
+		return result;
+	}
+};
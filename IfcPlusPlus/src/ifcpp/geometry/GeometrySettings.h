@@ -53,6 +53,8 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 
 class StatusCallback;
 class CarveMeshNormalizer;
+class GeometryProfiler;
+class TaskScheduler;
 struct GeomProcessingParams;
 namespace carve { namespace mesh { template <unsigned int ndim>	class MeshSet; } }
 using MeshSimplifyCallbackType = std::function<void(shared_ptr<carve::mesh::MeshSet<3> >& meshset, const GeomProcessingParams& params)>;
@@ -85,10 +87,29 @@ public:
 		m_epsCoplanarAngle = other->m_epsCoplanarAngle;
 		m_mergeAlignedEdges = other->m_mergeAlignedEdges;
 		m_callback_simplify_mesh = other->m_callback_simplify_mesh;
+		m_num_threads = other->m_num_threads;
+		m_max_chordal_deviation = other->m_max_chordal_deviation;
+		m_max_angle_deviation = other->m_max_angle_deviation;
+		m_max_num_vertices_per_circle = other->m_max_num_vertices_per_circle;
+		m_levels_of_detail = other->m_levels_of_detail;
+		m_subtract_extruded_openings_2d = other->m_subtract_extruded_openings_2d;
+		m_profiler = other->m_profiler;
+		m_task_scheduler = other->m_task_scheduler;
+		m_create_finalized_meshes = other->m_create_finalized_meshes;
+		m_release_half_edge_meshes = other->m_release_half_edge_meshes;
+		m_finalized_mesh_crease_angle = other->m_finalized_mesh_crease_angle;
+		m_report_self_intersections = other->m_report_self_intersections;
 	}
 
 	// Number of discretization points per circle
-	int getNumVerticesPerCircleWithRadius(double radius) { return m_num_vertices_per_circle_given_radius(radius); }
+	int getNumVerticesPerCircleWithRadius(double radius)
+	{
+		if (isAdaptiveTessellation())
+		{
+			return getNumAdaptiveSegments(radius, 2.0 * M_PI, 3);
+		}
+		return m_num_vertices_per_circle_given_radius(radius);
+	}
 	int getNumVerticesPerCircle() { return m_num_vertices_per_circle; }
 	void setNumVerticesPerCircle(int num) { m_num_vertices_per_circle = num; }
 	void resetNumVerticesPerCircle() { m_num_vertices_per_circle = m_num_vertices_per_circle_default; }
@@ -99,6 +120,69 @@ public:
 	void resetMinNumVerticesPerArc() { m_min_num_vertices_per_arc = 6; }
 	void setMinNumVerticesPerArc(int num) { m_min_num_vertices_per_arc = num; }
 
+	/**\brief getNumVerticesPerArc: number of vertices of a circular arc, including start and end point.
+	With fixed vertex counts, this is the share of getNumVerticesPerCircleWithRadius, but at least getMinNumVerticesPerArc.
+	In adaptive mode, the number follows from the tessellation tolerances, and getMinNumVerticesPerArc is not applied */
+	int getNumVerticesPerArc(double radius, double openingAngle)
+	{
+		if (isAdaptiveTessellation())
+		{
+			return getNumAdaptiveSegments(radius, openingAngle, 1) + 1;
+		}
+		int num_vertices = int(m_num_vertices_per_circle_given_radius(radius) * std::abs(openingAngle) / (2.0 * M_PI));
+		if (num_vertices < m_min_num_vertices_per_arc)
+		{
+			num_vertices = m_min_num_vertices_per_arc;
+		}
+		return num_vertices;
+	}
+
+	/**\brief setTessellationTolerance: adaptive tessellation of circles, arcs, ellipses, splines, swept disks and revolved solids.
+	maxChordalDeviation: maximum distance between the exact curve and its polyline, in meter (the unit of the converted geometry).
+	maxAngleDeviation: maximum angle in radian between two adjacent segments of a polyline.
+	A value of 0 disables the criterion. If both are 0 (default), the fixed vertex counts (setNumVerticesPerCircle etc.) are used */
+	void setTessellationTolerance(double maxChordalDeviation, double maxAngleDeviation)
+	{
+		m_max_chordal_deviation = maxChordalDeviation;
+		m_max_angle_deviation = maxAngleDeviation;
+	}
+	double getMaxChordalDeviation() { return m_max_chordal_deviation; }
+	double getMaxAngleDeviation() { return m_max_angle_deviation; }
+	bool isAdaptiveTessellation() { return m_max_chordal_deviation > 0 || m_max_angle_deviation > 0; }
+
+	//\brief setMaxNumVerticesPerCircle: upper limit for adaptive tessellation, so that a very small tolerance on a huge radius does not produce millions of points
+	void setMaxNumVerticesPerCircle(int num) { m_max_num_vertices_per_circle = num; }
+	int getMaxNumVerticesPerCircle() { return m_max_num_vertices_per_circle; }
+
+	//\brief getNumAdaptiveSegments: number of segments of an arc, so that both the chordal deviation and the angle between adjacent segments are within the tolerances
+	int getNumAdaptiveSegments(double radius, double openingAngle, int minNumSegments)
+	{
+		openingAngle = std::abs(openingAngle);
+		double maxSegmentAngle = 2.0 * M_PI;
+		if (m_max_chordal_deviation > 0 && radius > m_max_chordal_deviation)
+		{
+			// deviation of a chord with angle a: radius*(1 - cos(a/2))
+			maxSegmentAngle = 2.0 * std::acos(1.0 - m_max_chordal_deviation / radius);
+		}
+		if (m_max_angle_deviation > 0 && m_max_angle_deviation < maxSegmentAngle)
+		{
+			// the angle between two adjacent segments equals the angle of one segment
+			maxSegmentAngle = m_max_angle_deviation;
+		}
+
+		double numSegments = std::ceil(openingAngle / maxSegmentAngle - 1e-9);
+		double maxNumSegments = std::ceil(m_max_num_vertices_per_circle * openingAngle / (2.0 * M_PI));
+		if (numSegments > maxNumSegments)
+		{
+			numSegments = maxNumSegments;
+		}
+		if (numSegments < minNumSegments)
+		{
+			numSegments = minNumSegments;
+		}
+		return int(numSegments);
+	}
+
 	int getNumVerticesPerControlPoint() { return m_num_vertices_per_control_point; }
 	void setNumVerticesPerControlPoint(int num) { m_num_vertices_per_control_point = num; }
 	void resetNumVerticesPerControlPoint() { m_num_vertices_per_control_point = m_num_vertices_per_control_point_default; }
@@ -142,6 +226,41 @@ public:
 		return m_epsCoplanarAngle;
 	}
 
+	/**\brief setNumThreads: maximum number of threads used for geometry conversion, including the calling thread.
+	0 means std::thread::hardware_concurrency, 1 converts all products sequentially */
+	void setNumThreads(int num_threads) { m_num_threads = num_threads; }
+	int getNumThreads() { return m_num_threads; }
+
+	/**\brief setLevelsOfDetail: GeometryConverter creates additional, coarser meshes for each product in the same conversion run, see ProductShapeData::m_levels_of_detail.
+	Each value defines one level: the minimum edge length in meter, shorter edges of the converted meshes are collapsed. Empty (default): no levels of detail */
+	void setLevelsOfDetail(const std::vector<double>& minEdgeLengths) { m_levels_of_detail = minEdgeLengths; }
+	const std::vector<double>& getLevelsOfDetail() { return m_levels_of_detail; }
+
+	/**\brief setSubtractExtrudedOpenings2D: openings that are prisms along the same direction as a prismatic element, reach through it and are enclosed by
+	its cross section, are added to the cross section as holes, and the result is extruded once, see ExtrudedOpeningSubtractor. Other openings use the general CSG.
+	Off by default */
+	void setSubtractExtrudedOpenings2D(bool subtract2D) { m_subtract_extruded_openings_2d = subtract2D; }
+	bool isSubtractExtrudedOpenings2D() { return m_subtract_extruded_openings_2d; }
+
+	/**\brief setCreateFinalizedMeshes: after all boolean operations, GeometryConverter creates an indexed triangle mesh (ItemShapeData::m_finalized_mesh) of each item,
+	that exporters can copy directly. If releaseHalfEdgeMeshes is set, the carve meshsets of the items are released afterwards to save memory,
+	so consumers that read ItemShapeData::m_meshsets (ConverterOSG for example) only get the finalized meshes */
+	void setCreateFinalizedMeshes(bool createFinalizedMeshes, bool releaseHalfEdgeMeshes)
+	{
+		m_create_finalized_meshes = createFinalizedMeshes;
+		m_release_half_edge_meshes = releaseHalfEdgeMeshes;
+	}
+	bool isCreateFinalizedMeshes() { return m_create_finalized_meshes; }
+	bool isReleaseHalfEdgeMeshes() { return m_release_half_edge_meshes; }
+
+	//\brief setFinalizedMeshCreaseAngle: faces that meet at a smaller angle (in radians) share vertices and get smoothed normals in the finalized mesh
+	void setFinalizedMeshCreaseAngle(double angle) { m_finalized_mesh_crease_angle = angle; }
+	double getFinalizedMeshCreaseAngle() { return m_finalized_mesh_crease_angle; }
+
+	//\brief setReportSelfIntersections: if set, face loops of swept solids and faces are checked for self-intersections, and a warning is sent for each self-intersecting loop
+	void setReportSelfIntersections(bool report) { m_report_self_intersections = report; }
+	bool isReportSelfIntersections() { return m_report_self_intersections; }
+
 	bool skipRenderObject(uint32_t classID)
 	{
 		if (m_excludeIfcTypes.find(classID) != m_excludeIfcTypes.end())
@@ -166,6 +285,8 @@ public:
 	bool m_mergeAlignedEdges = true;
 	MeshSimplifyCallbackType m_callback_simplify_mesh;
 	std::map<int, std::vector<int>, std::greater<int> > m_mapCsgTimeTag;
+	shared_ptr<GeometryProfiler> m_profiler;		// if set, conversion times and CSG statistics are recorded, see GeometryConverter::setProfilingEnabled
+	shared_ptr<TaskScheduler> m_task_scheduler;	// if set, large boolean operations compute the face pair intersections in parallel, set by RepresentationConverter
 	
 protected:
 	int	m_num_vertices_per_circle = 14;
@@ -181,6 +302,16 @@ protected:
 	double m_min_triangle_area = EPS_MIN_FACE_AREA;
 	double m_epsilonMergePoints = EPS_DEFAULT;
 	double m_epsCoplanarAngle = EPS_ANGLE_COPLANAR_FACES;
+	int m_num_threads = 0;
+	double m_max_chordal_deviation = 0;
+	double m_max_angle_deviation = 0;
+	int m_max_num_vertices_per_circle = 256;
+	std::vector<double> m_levels_of_detail;
+	bool m_subtract_extruded_openings_2d = false;
+	bool m_create_finalized_meshes = false;
+	bool m_release_half_edge_meshes = false;
+	double m_finalized_mesh_crease_angle = 0.5;
+	bool m_report_self_intersections = false;
 
 	std::function<int(double)> m_num_vertices_per_circle_given_radius = [&](double radius)
 	{
@@ -226,6 +357,10 @@ struct GeomProcessingParams
 		this->treatLongThinFaceAsDegenerate = other.treatLongThinFaceAsDegenerate;
 		this->debugDump = other.debugDump;
 		this->normalizer = other.normalizer;
+		this->openEdgeRepairMaxNumFaces = other.openEdgeRepairMaxNumFaces;
+		this->openEdgeRepairMaxNumOpenEdges = other.openEdgeRepairMaxNumOpenEdges;
+		this->openEdgeRepairMaxNumEdgesPerFace = other.openEdgeRepairMaxNumEdgesPerFace;
+		this->openEdgeRepairMaxSeconds = other.openEdgeRepairMaxSeconds;
 	}
 	shared_ptr<GeometrySettings> generalSettings;
 	BuildingEntity* ifc_entity = nullptr;
@@ -244,4 +379,10 @@ struct GeomProcessingParams
 	bool treatLongThinFaceAsDegenerate = false;
 	bool debugDump = false;
 	CarveMeshNormalizer* normalizer = nullptr;
+
+	// Budgets for MeshOps::intersectOpenEdgesWithPoints/intersectOpenEdgesWithEdges. If a budget is exceeded, the mesh is left as it is
+	size_t openEdgeRepairMaxNumFaces = 100000;
+	size_t openEdgeRepairMaxNumOpenEdges = 20000;
+	size_t openEdgeRepairMaxNumEdgesPerFace = 2000;
+	double openEdgeRepairMaxSeconds = 10.0;	// 0: no time limit
 };
@@ -0,0 +1,290 @@
+/* -*-c++-*- IfcQuery www.ifcquery.com
+*
+MIT License
+
+Copyright (c) 2017 Fabian Gerold
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <earcut/include/mapbox/earcut.hpp>
+#include <ifcpp/model/BasicTypes.h>
+#include "IncludeCarveHeaders.h"
+#include "GeomUtils.h"
+#include "GeometryInputData.h"
+
+/**
+*\brief Class MeshFinalizer: converts the half-edge meshsets of an item into a FinalizedMeshData, an indexed triangle mesh in flat arrays.
+* Faces with more than three edges are triangulated. A vertex is shared by the faces around it that meet at less than the crease angle, those get an
+* area weighted average normal. Across sharper edges the vertex is split, so that flat faces keep their face normal.
+*/
+class MeshFinalizer
+{
+public:
+	/**\brief finalizeItem: creates item->m_finalized_mesh from m_meshsets and m_meshsets_open, recursively for the child items. Optionally releases the meshsets afterwards
+	\param[in] inheritedStyleId Style id of the parent item or product, used for the triangles of items without an own surface style
+	**/
+	static void finalizeItem(const shared_ptr<ItemShapeData>& item, double creaseAngle, bool releaseHalfEdgeMeshes, int inheritedStyleId = -1)
+	{
+		if (!item)
+		{
+			return;
+		}
+
+		int styleId = getSurfaceStyleId(item->m_styles);
+		if (styleId < 0)
+		{
+			styleId = inheritedStyleId;
+		}
+
+		if (item->m_meshsets.size() > 0 || item->m_meshsets_open.size() > 0)
+		{
+			shared_ptr<FinalizedMeshData> finalized = make_shared<FinalizedMeshData>();
+			for (const shared_ptr<carve::mesh::MeshSet<3> >& meshset : item->m_meshsets)
+			{
+				appendMeshSet(meshset.get(), creaseAngle, styleId, *finalized);
+			}
+			for (const shared_ptr<carve::mesh::MeshSet<3> >& meshset : item->m_meshsets_open)
+			{
+				appendMeshSet(meshset.get(), creaseAngle, styleId, *finalized);
+			}
+			finalized->m_positions.shrink_to_fit();
+			finalized->m_normals.shrink_to_fit();
+			finalized->m_indices.shrink_to_fit();
+			finalized->m_triangle_style_ids.shrink_to_fit();
+			item->m_finalized_mesh = finalized;
+
+			if (releaseHalfEdgeMeshes)
+			{
+				item->m_meshsets.clear();
+				item->m_meshsets_open.clear();
+			}
+		}
+
+		for (const shared_ptr<ItemShapeData>& child : item->m_child_items)
+		{
+			finalizeItem(child, creaseAngle, releaseHalfEdgeMeshes, styleId);
+		}
+	}
+
+	/**\brief appendMeshSet: adds the triangles of all meshes in meshset to target
+	\param[in] creaseAngle Faces meeting at a smaller angle (radians) share their vertices
+	\param[in] styleId Written to m_triangle_style_ids for each triangle
+	**/
+	static void appendMeshSet(const carve::mesh::MeshSet<3>* meshset, double creaseAngle, int styleId, FinalizedMeshData& target)
+	{
+		if (!meshset || meshset->vertex_storage.size() == 0)
+		{
+			return;
+		}
+
+		const double cosCreaseAngle = std::cos(creaseAngle);
+		const carve::mesh::Vertex<3>* vertexBase = &meshset->vertex_storage[0];
+
+		// for each input vertex the output vertices created from it, with the normal of the first face as reference for the crease angle
+		struct OutputVertex
+		{
+			vec3 referenceNormal;
+			uint32_t index;
+		};
+		std::vector<std::vector<OutputVertex> > outputVertices(meshset->vertex_storage.size());
+		std::vector<vec3> accumulatedNormals;
+		const size_t firstOutputVertex = target.getNumVertices();
+
+		std::vector<carve::mesh::Vertex<3>* > faceVertices;
+		std::vector<uint32_t> faceIndices;
+		std::vector<uint32_t> triangles;
+		for (const carve::mesh::Mesh<3>* mesh : meshset->meshes)
+		{
+			for (const carve::mesh::Face<3>* face : mesh->faces)
+			{
+				faceVertices.clear();
+				face->getVertices(faceVertices);
+				if (faceVertices.size() < 3)
+				{
+					continue;
+				}
+
+				vec3 faceNormal = computeNormal(faceVertices);
+				double faceNormalLength = faceNormal.length();
+				if (faceNormalLength < EPS_M16)
+				{
+					continue;
+				}
+				faceNormal = faceNormal / faceNormalLength;
+
+				triangles.clear();
+				triangulateFace(faceVertices, faceNormal, triangles);
+				if (triangles.size() < 3)
+				{
+					continue;
+				}
+
+				// output vertex for each corner of the face
+				faceIndices.resize(faceVertices.size());
+				for (size_t ii = 0; ii < faceVertices.size(); ++ii)
+				{
+					const carve::mesh::Vertex<3>* vertex = faceVertices[ii];
+					std::vector<OutputVertex>& candidates = outputVertices[vertex - vertexBase];
+					uint32_t outputIndex = UINT32_MAX;
+					for (const OutputVertex& candidate : candidates)
+					{
+						if (dot(candidate.referenceNormal, faceNormal) >= cosCreaseAngle)
+						{
+							outputIndex = candidate.index;
+							break;
+						}
+					}
+					if (outputIndex == UINT32_MAX)
+					{
+						outputIndex = uint32_t(target.getNumVertices());
+						target.m_positions.push_back(vertex->v.x);
+						target.m_positions.push_back(vertex->v.y);
+						target.m_positions.push_back(vertex->v.z);
+						accumulatedNormals.push_back(carve::geom::VECTOR(0, 0, 0));
+						candidates.push_back({ faceNormal, outputIndex });
+					}
+					faceIndices[ii] = outputIndex;
+				}
+
+				for (size_t ii = 0; ii + 2 < triangles.size(); ii += 3)
+				{
+					const uint32_t idxA = faceIndices[triangles[ii]];
+					const uint32_t idxB = faceIndices[triangles[ii + 1]];
+					const uint32_t idxC = faceIndices[triangles[ii + 2]];
+					if (idxA == idxB || idxA == idxC || idxB == idxC)
+					{
+						continue;
+					}
+					target.m_indices.push_back(idxA);
+					target.m_indices.push_back(idxB);
+					target.m_indices.push_back(idxC);
+					target.m_triangle_style_ids.push_back(styleId);
+
+					// area weighted, so that small triangles of a fan do not dominate the normal of a vertex
+					const vec3& pointA = faceVertices[triangles[ii]]->v;
+					const vec3& pointB = faceVertices[triangles[ii + 1]]->v;
+					const vec3& pointC = faceVertices[triangles[ii + 2]]->v;
+					vec3 weightedNormal = carve::geom::cross(pointB - pointA, pointC - pointA);
+					if (dot(weightedNormal, faceNormal) < 0)
+					{
+						weightedNormal = faceNormal * weightedNormal.length();
+					}
+					accumulatedNormals[idxA - firstOutputVertex] += weightedNormal;
+					accumulatedNormals[idxB - firstOutputVertex] += weightedNormal;
+					accumulatedNormals[idxC - firstOutputVertex] += weightedNormal;
+				}
+			}
+		}
+
+		for (size_t ii = 0; ii < accumulatedNormals.size(); ++ii)
+		{
+			vec3 normal = accumulatedNormals[ii];
+			double length = normal.length();
+			if (length > EPS_M16)
+			{
+				normal = normal / length;
+			}
+			target.m_normals.push_back(float(normal.x));
+			target.m_normals.push_back(float(normal.y));
+			target.m_normals.push_back(float(normal.z));
+		}
+	}
+
+	//\brief getSurfaceStyleId: StyleData::m_step_style_id of the first style that applies to surfaces, -1 if there is none
+	static int getSurfaceStyleId(const std::vector<shared_ptr<StyleData> >& styles)
+	{
+		for (const shared_ptr<StyleData>& style : styles)
+		{
+			if (!style)
+			{
+				continue;
+			}
+			if (style->m_apply_to_geometry_type == StyleData::GEOM_TYPE_SURFACE || style->m_apply_to_geometry_type == StyleData::GEOM_TYPE_VOLUME || style->m_apply_to_geometry_type == StyleData::GEOM_TYPE_ANY)
+			{
+				return style->m_step_style_id;
+			}
+		}
+		return -1;
+	}
+
+protected:
+	// Newell's method, robust for non-convex faces
+	static vec3 computeNormal(const std::vector<carve::mesh::Vertex<3>* >& faceVertices)
+	{
+		vec3 normal = carve::geom::VECTOR(0, 0, 0);
+		for (size_t ii = 0; ii < faceVertices.size(); ++ii)
+		{
+			const vec3& current = faceVertices[ii]->v;
+			const vec3& next = faceVertices[(ii + 1) % faceVertices.size()]->v;
+			normal.x += (current.y - next.y) * (current.z + next.z);
+			normal.y += (current.z - next.z) * (current.x + next.x);
+			normal.z += (current.x - next.x) * (current.y + next.y);
+		}
+		return normal;
+	}
+
+	//\brief triangulateFace: indices into faceVertices, three per triangle, oriented like faceNormal
+	static void triangulateFace(const std::vector<carve::mesh::Vertex<3>* >& faceVertices, const vec3& faceNormal, std::vector<uint32_t>& triangles)
+	{
+		const size_t numVertices = faceVertices.size();
+		if (numVertices == 3)
+		{
+			triangles.insert(triangles.end(), { 0, 1, 2 });
+			return;
+		}
+
+		// project along the dominant axis of the normal
+		int dropAxis = 2;
+		if (std::abs(faceNormal.x) > std::abs(faceNormal.y) && std::abs(faceNormal.x) > std::abs(faceNormal.z))
+		{
+			dropAxis = 0;
+		}
+		else if (std::abs(faceNormal.y) > std::abs(faceNormal.z))
+		{
+			dropAxis = 1;
+		}
+		const int axisU = dropAxis == 0 ? 1 : 0;
+		const int axisV = dropAxis == 2 ? 1 : 2;
+
+		std::vector<std::vector<array2d> > loopsForEarcut(1);
+		std::vector<array2d>& loop2D = loopsForEarcut[0];
+		loop2D.reserve(numVertices);
+		for (const carve::mesh::Vertex<3>* vertex : faceVertices)
+		{
+			loop2D.push_back({ vertex->v.v[axisU], vertex->v.v[axisV] });
+		}
+
+		std::vector<uint32_t> triangulated = mapbox::earcut<uint32_t>(loopsForEarcut);
+		for (size_t ii = 0; ii + 2 < triangulated.size(); ii += 3)
+		{
+			uint32_t idxA = triangulated[ii];
+			uint32_t idxB = triangulated[ii + 1];
+			uint32_t idxC = triangulated[ii + 2];
+
+			// earcut does not keep the orientation
+			const vec3& pointA = faceVertices[idxA]->v;
+			const vec3& pointB = faceVertices[idxB]->v;
+			const vec3& pointC = faceVertices[idxC]->v;
+			if (dot(carve::geom::cross(pointB - pointA, pointC - pointA), faceNormal) < 0)
+			{
+				std::swap(idxB, idxC);
+			}
+			triangles.push_back(idxA);
+			triangles.push_back(idxB);
+			triangles.push_back(idxC);
+		}
+	}
+};
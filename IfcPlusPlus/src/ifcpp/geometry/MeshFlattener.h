@@ -216,7 +216,6 @@ public:
 
 		// then re-compute the set of faces plane normals. Then check again which faces are in the plane
 		compute(params);
-
 	}
 
 	void compute( const GeomProcessingParams& params)
@@ -227,6 +226,9 @@ public:
 		double epsDistanceFaceCentroids = params.epsMergePoints * 10.0;
 		double epsMinDistanceMovePoints2 = params.epsMergePoints * 0.01 * params.epsMergePoints * 0.01;
 
+		// moved vertices invalidate the face trees and cached metrics
+		std::unordered_set<carve::mesh::MeshSet<3>*> setChangedMeshSets;
+
 		for (auto it : m_mapInPlaneFaces)
 		{
 			std::vector<shared_ptr<SetOfFacesInPlane> >& vecOfSetOfFaces = it.second;
@@ -291,7 +293,11 @@ public:
 								++m_numCorrectedVertices;
 								if (face->mesh)
 								{
-									face->mesh->m_volume = std::numeric_limits<double>::quiet_NaN();
+									face->mesh->resetVolume();
+									if (face->mesh->meshset)
+									{
+										setChangedMeshSets.insert(face->mesh->meshset);
+									}
 								}
 #ifdef _DEBUG
 								if (distance2 > EPS_M9)
@@ -305,6 +311,11 @@ public:
 				}
 			}
 		}
+
+		for (carve::mesh::MeshSet<3>* meshset : setChangedMeshSets)
+		{
+			meshset->refitFaceTree();
+		}
 	}
 
 
@@ -480,6 +491,12 @@ public:
 				//#endif
 			}
 		}
+
+		op1->refitFaceTree();
+		if (op2)
+		{
+			op2->refitFaceTree();
+		}
 	}
 };
 
@@ -69,14 +69,20 @@ public:
 		m_normalizeCenter.setZero();
 	}
 
-	void normalizeMesh(shared_ptr<carve::mesh::MeshSet<3> >& meshset, std::string tag, double eps)
+	//\brief isIdentity: true if normalizeMesh and deNormalizeMesh leave meshes unchanged
+	bool isIdentity() const
 	{
 		if (m_disableNormalizeAll)
 		{
-			return;
+			return true;
 		}
 		double centerLength2 = m_normalizeCenter.length2();
-		if (m_scale == 1.0 && centerLength2 < 2.0)
+		return m_scale == 1.0 && centerLength2 < 2.0;
+	}
+
+	void normalizeMesh(shared_ptr<carve::mesh::MeshSet<3> >& meshset, std::string tag, double eps)
+	{
+		if (isIdentity())
 		{
 			return;
 		}
@@ -113,18 +119,15 @@ public:
 			carve::mesh::Mesh<3>* mesh = meshset->meshes[kk];
 			mesh->recalc(eps);
 		}
+		// only the vertices moved, so a cached face tree can be kept with updated extents
+		meshset->refitFaceTree();
 
 		m_normalizedMeshes.insert({ tag, meshset.get() });
 	}
 
 	void deNormalizeMesh(shared_ptr<carve::mesh::MeshSet<3> >& meshset, std::string tag, double eps)
 	{
-		if (m_disableNormalizeAll)
-		{
-			return;
-		}
-		double centerLength2 = m_normalizeCenter.length2();
-		if (m_scale == 1.0 && centerLength2 < 2.0)
+		if (isIdentity())
 		{
 			return;
 		}
@@ -162,5 +165,6 @@ public:
 			carve::mesh::Mesh<3>* mesh = meshset->meshes[kk];
 			mesh->recalc(eps);
 		}
+		meshset->refitFaceTree();
 	}
 };
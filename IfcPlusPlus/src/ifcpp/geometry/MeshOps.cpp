@@ -15,7 +15,9 @@ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTH
 LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <chrono>
 #include "IncludeCarveHeaders.h"
+#include <carve/rtree.hpp>
 #include <ifcpp/geometry/FaceConverter.h>
 #include <ifcpp/IFC4X3/include/IfcCartesianPoint.h>
 #include "EdgeLoopFinder.h"
@@ -1211,6 +1213,7 @@ void MeshOps::removeDegenerateMeshes(shared_ptr<carve::mesh::MeshSet<3> >& meshs
 
 	if( numRemovedMeshes > 0 )
 	{
+		meshsetInput->invalidateFaceTree();
 		for( auto it = meshsetInput->meshes.begin(); it != meshsetInput->meshes.end(); ++it )
 		{
 			carve::mesh::Mesh<3>* mesh = *it;
@@ -2137,15 +2140,39 @@ double MeshOps::computeMeshSetSurface(const shared_ptr<carve::mesh::MeshSet<3> >
 	const std::vector<carve::mesh::Mesh<3>* >& vec_meshes = meshset->meshes;
 	for (size_t kk = 0; kk < vec_meshes.size(); ++kk)
 	{
-		const carve::mesh::Mesh<3>* mesh = vec_meshes[kk];
-		const std::vector<carve::mesh::Face<3>* >& vec_faces = mesh->faces;
-		for (size_t mm = 0; mm < vec_faces.size(); ++mm)
+		carve::mesh::Mesh<3>* mesh = vec_meshes[kk];
+		surface_area += mesh->surfaceArea();
+	}
+	return surface_area;
+}
+
+carve::geom::aabb<3> MeshOps::computeMeshSetAABB(const carve::mesh::MeshSet<3>* meshset)
+{
+	carve::geom::aabb<3> bbox;
+	if (!meshset)
+	{
+		return bbox;
+	}
+
+	bool first = true;
+	for (carve::mesh::Mesh<3>* mesh : meshset->meshes)
+	{
+		if (mesh->faces.size() == 0)
+		{
+			continue;
+		}
+
+		if (first)
+		{
+			bbox = mesh->metricsAABB();
+			first = false;
+		}
+		else
 		{
-			const carve::mesh::Face<3>* face = vec_faces[mm];
-			surface_area += computeFaceArea(face);
+			bbox.unionAABB(mesh->metricsAABB());
 		}
 	}
-	return surface_area;
+	return bbox;
 }
 
 double MeshOps::computeShapeSurfaceArea(const shared_ptr<ItemShapeData>& geomItem)
@@ -2591,6 +2618,77 @@ bool intersectRayTriangle(const glm::dvec3& rayOrigin, const glm::dvec3& rayDire
 	return false;
 }
 
+///\brief OpenEdgeRepairBudget: stops the open edge repair if it takes longer than GeomProcessingParams::openEdgeRepairMaxSeconds
+class OpenEdgeRepairBudget
+{
+public:
+	OpenEdgeRepairBudget(const GeomProcessingParams& params) : m_maxSeconds(params.openEdgeRepairMaxSeconds), m_start(std::chrono::steady_clock::now())
+	{
+	}
+
+	bool isExceeded()
+	{
+		if (m_maxSeconds <= 0)
+		{
+			return false;
+		}
+		// checking the clock for each face would be too expensive for meshes with many small faces
+		if (++m_numChecks % 64 != 0)
+		{
+			return false;
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+		return elapsed.count() > m_maxSeconds;
+	}
+
+protected:
+	double m_maxSeconds = 0;
+	size_t m_numChecks = 0;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+///\brief element of an rtree over the open edges of a mesh. The index is used to visit the search result in the original order
+struct OpenEdgeTreeEntry
+{
+	OpenEdgeTreeEntry() {}
+	OpenEdgeTreeEntry(const carve::mesh::Edge<3>* _edge, size_t _index) : edge(_edge), index(_index) {}
+	carve::geom::aabb<3> getAABB() const
+	{
+		carve::geom::aabb<3> bbox;
+		bbox.fit(edge->v1()->v, edge->v2()->v);
+		return bbox;
+	}
+	const carve::mesh::Edge<3>* edge = nullptr;
+	size_t index = 0;
+};
+
+///\brief element of an rtree over the vertices of a MeshSet
+struct VertexTreeEntry
+{
+	VertexTreeEntry() {}
+	VertexTreeEntry(const carve::mesh::Vertex<3>* _vertex, size_t _index) : vertex(_vertex), index(_index) {}
+	carve::geom::aabb<3> getAABB() const
+	{
+		return carve::geom::aabb<3>(vertex->v, carve::geom::vector<3>::ZERO());
+	}
+	const carve::mesh::Vertex<3>* vertex = nullptr;
+	size_t index = 0;
+};
+
+template<typename TEntry>
+inline void searchTreeSorted(const carve::geom::RTreeNode<3, TEntry>* tree, const vec3& segmentStart, const vec3& segmentEnd, double eps, std::vector<TEntry>& result)
+{
+	result.clear();
+	if (!tree)
+	{
+		return;
+	}
+	carve::geom::aabb<3> bbox;
+	bbox.fit(segmentStart, segmentEnd);
+	tree->search(bbox, std::back_inserter(result), eps);
+	std::sort(result.begin(), result.end(), [](const TEntry& a, const TEntry& b) { return a.index < b.index; });
+}
+
 ///\brief method intersectOpenEdges: Intersect open edges of MeshSet with closed edges, and split the open edges in case of intersection
 ///\param[in/out] meshset: MeshSet with open edges. If fix is found, a new MeshSet is assigned to the smart pointer
 ///\param[in] eps: tolerance to find edge-edge intersections
@@ -2602,10 +2700,9 @@ void MeshOps::intersectOpenEdgesWithPoints(shared_ptr<carve::mesh::MeshSet<3> >&
 		return;
 	}
 
-	size_t maxNumFaces = 2000;
-	size_t maxNumEdges = 2000;
-	size_t maxNumOpenEdges = 100;
+	const size_t maxNumEdges = params.openEdgeRepairMaxNumEdgesPerFace;
 	double eps = params.epsMergePoints * 1.2;
+	OpenEdgeRepairBudget budget(params);
 
 #ifdef _DEBUG
 	vec4 color(0.5, 0.6, 0.7, 1.0);
@@ -2634,7 +2731,17 @@ void MeshOps::intersectOpenEdgesWithPoints(shared_ptr<carve::mesh::MeshSet<3> >&
 			std::copy(mesh->faces.begin(), mesh->faces.end(), std::back_inserter(allFaces));
 		}
 
-		std::set<carve::mesh::Face<3>* > setOpenEdgesAdjacentFaces;
+		if (allOpenEdges.size() == 0)
+		{
+			return;
+		}
+
+		if (allFaces.size() > params.openEdgeRepairMaxNumFaces || allOpenEdges.size() > params.openEdgeRepairMaxNumOpenEdges)
+		{
+			return;
+		}
+
+		std::unordered_set<carve::mesh::Face<3>* > setOpenEdgesAdjacentFaces;
 		for (size_t ii = 0; ii < allOpenEdges.size(); ++ii)
 		{
 			carve::mesh::Edge<3>* openEdge = allOpenEdges[ii];
@@ -2642,13 +2749,29 @@ void MeshOps::intersectOpenEdgesWithPoints(shared_ptr<carve::mesh::MeshSet<3> >&
 			setOpenEdgesAdjacentFaces.insert(adjacentFace);
 		}
 
+		// rtree over all vertices, so that each edge is tested only against the vertices close to it
+		std::vector<VertexTreeEntry> vertexEntries;
+		vertexEntries.reserve(meshsetInput->vertex_storage.size());
+		for (size_t iiVertex = 0; iiVertex < meshsetInput->vertex_storage.size(); ++iiVertex)
+		{
+			vertexEntries.push_back(VertexTreeEntry(&meshsetInput->vertex_storage[iiVertex], iiVertex));
+		}
+		typedef carve::geom::RTreeNode<3, VertexTreeEntry> vertex_rtree_t;
+		std::unique_ptr<vertex_rtree_t> vertexTree;
+		if (vertexEntries.size() > 0)
+		{
+			vertexTree.reset(vertex_rtree_t::construct_STR(vertexEntries.begin(), vertexEntries.end(), 4, 4));
+		}
+		std::vector<VertexTreeEntry> nearVertices;
+
 		PolyInputCache3D polyInput(params.epsMergePoints);
+		polyInput.reservePoints(meshsetInput->vertex_storage.size() + allOpenEdges.size());
 
 		// intersect with closed edges
 		size_t numSplitEdges = 0;
 		for (size_t iiFace = 0; iiFace < allFaces.size(); ++iiFace)
 		{
-			if (iiFace > maxNumFaces)
+			if (budget.isExceeded())
 			{
 				return;
 			}
@@ -2696,10 +2819,10 @@ void MeshOps::intersectOpenEdgesWithPoints(shared_ptr<carve::mesh::MeshSet<3> >&
 					std::map<double, vec3> mapIntersections;
 
 					// check if current edge needs to be split
-					for (size_t iiVertex = 0; iiVertex < meshsetInput->vertex_storage.size(); ++iiVertex)
+					searchTreeSorted(vertexTree.get(), edgePoint1, edgePoint2, eps, nearVertices);
+					for (size_t iiVertex = 0; iiVertex < nearVertices.size(); ++iiVertex)
 					{
-						const carve::mesh::Vertex<3>& vert = meshsetInput->vertex_storage[iiVertex];
-						vec3 vertexPoint = vert.v;
+						const vec3& vertexPoint = nearVertices[iiVertex].vertex->v;
 
 						double t = -1;
 						bool onSegment = GeomUtils::isPointOnLineSegment(edgePoint1, edgeDelta, dotLineSegDelta, vertexPoint, t, eps);
@@ -2879,10 +3002,9 @@ void MeshOps::intersectOpenEdgesWithEdges(shared_ptr<carve::mesh::MeshSet<3> >&
 		return;
 	}
 
-	size_t maxNumFaces = 600;
-	size_t maxNumEdges = 600;
-	size_t maxNumOpenEdges = 100;
+	const size_t maxNumEdges = params.openEdgeRepairMaxNumEdgesPerFace;
 	double eps = params.epsMergePoints;
+	OpenEdgeRepairBudget budget(params);
 
 #ifdef _DEBUG
 	vec4 color(0.5, 0.6, 0.7, 1.0);
@@ -2911,13 +3033,35 @@ void MeshOps::intersectOpenEdgesWithEdges(shared_ptr<carve::mesh::MeshSet<3> >&
 			std::copy(mesh->faces.begin(), mesh->faces.end(), std::back_inserter(allFaces));
 		}
 
+		if (allOpenEdges.size() == 0)
+		{
+			return;
+		}
+
+		if (allFaces.size() > params.openEdgeRepairMaxNumFaces || allOpenEdges.size() > params.openEdgeRepairMaxNumOpenEdges)
+		{
+			return;
+		}
+
+		// rtree over the open edges, so that each edge is tested only against the open edges close to it
+		std::vector<OpenEdgeTreeEntry> openEdgeEntries;
+		openEdgeEntries.reserve(allOpenEdges.size());
+		for (size_t iiOpenEdge = 0; iiOpenEdge < allOpenEdges.size(); ++iiOpenEdge)
+		{
+			openEdgeEntries.push_back(OpenEdgeTreeEntry(allOpenEdges[iiOpenEdge], iiOpenEdge));
+		}
+		typedef carve::geom::RTreeNode<3, OpenEdgeTreeEntry> edge_rtree_t;
+		std::unique_ptr<edge_rtree_t> openEdgeTree(edge_rtree_t::construct_STR(openEdgeEntries.begin(), openEdgeEntries.end(), 4, 4));
+		std::vector<OpenEdgeTreeEntry> nearOpenEdges;
+
 		PolyInputCache3D polyInput(params.epsMergePoints);
+		polyInput.reservePoints(meshset->vertex_storage.size() + allOpenEdges.size());
 
 		// intersect with closed edges
 		size_t numSplitEdges = 0;
 		for (size_t iiFace = 0; iiFace < allFaces.size(); ++iiFace)
 		{
-			if (iiFace > maxNumFaces)
+			if (budget.isExceeded())
 			{
 				return;
 			}
@@ -2944,15 +3088,10 @@ void MeshOps::intersectOpenEdgesWithEdges(shared_ptr<carve::mesh::MeshSet<3> >&
 			for (size_t i_edge = 0; i_edge < n_edges; ++i_edge)
 			{
 				// check if current edge needs to be split
-				for (size_t iiOpenEdge = 0; iiOpenEdge < allOpenEdges.size(); ++iiOpenEdge)
+				searchTreeSorted(openEdgeTree.get(), edge->v1()->v, edge->v2()->v, params.epsMergePoints, nearOpenEdges);
+				for (size_t iiOpenEdge = 0; iiOpenEdge < nearOpenEdges.size(); ++iiOpenEdge)
 				{
-					if (iiOpenEdge > maxNumOpenEdges)
-					{
-						return;
-					}
-					const carve::mesh::Edge<3>* openEdge = allOpenEdges[iiOpenEdge];
-					vec3 openEdgeStart = openEdge->v1()->v;
-					vec3 openEdgeEnd = openEdge->v2()->v;
+					const carve::mesh::Edge<3>* openEdge = nearOpenEdges[iiOpenEdge].edge;
 
 					vec3 intersectionPoint;
 					bool intersect = edgeToEdgeIntersect(openEdge, edge, params.epsMergePoints, intersectionPoint);
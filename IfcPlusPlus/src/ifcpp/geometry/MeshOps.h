@@ -29,6 +29,9 @@ public:
 	static double computeFaceArea(const carve::mesh::Face<3>* face, double& longestEdge);
 	static double computeMeshsetVolume(const carve::mesh::MeshSet<3>* meshset);
 	static double computeMeshSetSurface(const shared_ptr<carve::mesh::MeshSet<3> >& meshset);
+
+	/// \brief computeMeshSetAABB: bounding box of all meshes, taken from the cached mesh metrics. Same result as MeshSet::getAABB as long as moved vertices are followed by recalc or resetVolume
+	static carve::geom::aabb<3> computeMeshSetAABB(const carve::mesh::MeshSet<3>* meshset);
 	static double computeShapeSurfaceArea(const shared_ptr<ItemShapeData>& shape_input_data);
 	static double computeShapeSurfaceArea(const shared_ptr<ProductShapeData>& shape_input_data);
 	static size_t getNumFaces(const carve::mesh::MeshSet<3>* meshset);
@@ -0,0 +1,474 @@
+/* -*-c++-*- IfcQuery www.ifcquery.com
+*
+MIT License
+
+Copyright (c) 2017 Fabian Gerold
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <map>
+#include <vector>
+#include <earcut/include/mapbox/earcut.hpp>
+#include <ifcpp/model/BasicTypes.h>
+#include "IncludeCarveHeaders.h"
+#include "GeomUtils.h"
+#include "GeometrySettings.h"
+
+/**
+*\brief Class MeshPlaneClipper: cuts a closed meshset by a plane and closes the cut with cap faces, without the general CSG operation.
+* Used for IfcBooleanClippingResult, where the second operand is a half space. Each face is clipped against the plane, new vertices on the
+* cut edges are shared between the adjacent faces, and the open edges in the plane are chained to the loops of the caps.
+*/
+class MeshPlaneClipper
+{
+public:
+	/**\brief clipMeshSet: removes the part of the meshset on the negative side of the plane (the side the normal points away from).
+	\param[in,out] meshset Closed meshset. Set to nullptr if the meshset is completely on the negative side
+	\return false if the clipping is not possible (open input, ambiguous cut loops, faces cut into several parts), then the caller falls back to the general CSG
+	**/
+	static bool clipMeshSet(shared_ptr<carve::mesh::MeshSet<3> >& meshset, const carve::geom::plane<3>& plane, const GeomProcessingParams& params)
+	{
+		if (!meshset)
+		{
+			return false;
+		}
+		if (!meshset->isClosed())
+		{
+			return false;
+		}
+
+		const double eps = params.epsMergePoints;
+		const size_t numVertices = meshset->vertex_storage.size();
+		if (numVertices == 0)
+		{
+			return false;
+		}
+
+		// signed distances, snapped to the plane within eps
+		std::vector<double> distances(numVertices);
+		size_t numAbove = 0;
+		size_t numBelow = 0;
+		for (size_t ii = 0; ii < numVertices; ++ii)
+		{
+			double distance = carve::geom::distance(plane, meshset->vertex_storage[ii].v);
+			if (std::abs(distance) <= eps)
+			{
+				distance = 0;
+			}
+			else if (distance > 0)
+			{
+				++numAbove;
+			}
+			else
+			{
+				++numBelow;
+			}
+			distances[ii] = distance;
+		}
+
+		if (numBelow == 0)
+		{
+			// nothing to cut away
+			return true;
+		}
+		if (numAbove == 0)
+		{
+			// completely removed
+			meshset.reset();
+			return true;
+		}
+
+		const carve::mesh::Vertex<3>* firstVertex = &meshset->vertex_storage[0];
+		shared_ptr<carve::input::PolyhedronData> polyData(new carve::input::PolyhedronData());
+		std::vector<int> vertexIndexMap(numVertices, -1);
+		std::map<std::pair<size_t, size_t>, int> mapEdgeIntersections;
+
+		auto getVertexIndex = [&](size_t vertexIndex) -> int
+		{
+			if (vertexIndexMap[vertexIndex] < 0)
+			{
+				vertexIndexMap[vertexIndex] = polyData->addVertex(meshset->vertex_storage[vertexIndex].v);
+			}
+			return vertexIndexMap[vertexIndex];
+		};
+
+		auto getIntersectionIndex = [&](size_t idxA, size_t idxB) -> int
+		{
+			// the same point for both faces of the edge
+			std::pair<size_t, size_t> key = idxA < idxB ? std::make_pair(idxA, idxB) : std::make_pair(idxB, idxA);
+			auto it = mapEdgeIntersections.find(key);
+			if (it != mapEdgeIntersections.end())
+			{
+				return it->second;
+			}
+			const vec3& pointA = meshset->vertex_storage[key.first].v;
+			const vec3& pointB = meshset->vertex_storage[key.second].v;
+			double distA = distances[key.first];
+			double distB = distances[key.second];
+			vec3 point = pointA + (pointB - pointA) * (distA / (distA - distB));
+			int index = polyData->addVertex(point);
+			mapEdgeIntersections[key] = index;
+			return index;
+		};
+
+		std::map<std::pair<int, int>, size_t> mapDirectedEdges;
+		std::vector<std::vector<int> > resultFaces;
+		std::vector<size_t> faceVertexIndices;
+		for (const carve::mesh::Mesh<3>* mesh : meshset->meshes)
+		{
+			for (const carve::mesh::Face<3>* face : mesh->faces)
+			{
+				faceVertexIndices.clear();
+				const carve::mesh::Edge<3>* edge = face->edge;
+				size_t numFaceAbove = 0;
+				size_t numFaceBelow = 0;
+				for (size_t ii = 0; ii < face->n_edges; ++ii)
+				{
+					size_t vertexIndex = edge->vert - firstVertex;
+					faceVertexIndices.push_back(vertexIndex);
+					if (distances[vertexIndex] > 0) { ++numFaceAbove; }
+					else if (distances[vertexIndex] < 0) { ++numFaceBelow; }
+					edge = edge->next;
+				}
+
+				if (numFaceAbove == 0 && numFaceBelow == 0)
+				{
+					// face in the plane: keep it only if the solid is on the positive side
+					if (dot(face->plane.N, plane.N) > 0)
+					{
+						continue;
+					}
+				}
+				else if (numFaceAbove == 0)
+				{
+					continue;
+				}
+				else if (numFaceBelow > 0)
+				{
+					// a single loop is only a simple polygon if the face boundary crosses or touches the plane at most twice. Non-convex faces
+					// with several parts on the positive side would become one loop with overlapping edges along the cut line
+					auto isAbove = [&](size_t vertexIndex) { return distances[vertexIndex] > 0; };
+					auto isKept = [&](size_t vertexIndex) { return distances[vertexIndex] >= 0; };
+					if (countCyclicRuns(faceVertexIndices, isAbove) > 1 || countCyclicRuns(faceVertexIndices, isKept) > 1)
+					{
+						return false;
+					}
+				}
+
+				std::vector<int> faceLoop;
+				for (size_t ii = 0; ii < faceVertexIndices.size(); ++ii)
+				{
+					size_t idxCurrent = faceVertexIndices[ii];
+					size_t idxNext = faceVertexIndices[(ii + 1) % faceVertexIndices.size()];
+					double distCurrent = distances[idxCurrent];
+					double distNext = distances[idxNext];
+					if (distCurrent >= 0)
+					{
+						faceLoop.push_back(getVertexIndex(idxCurrent));
+					}
+					if ((distCurrent > 0 && distNext < 0) || (distCurrent < 0 && distNext > 0))
+					{
+						faceLoop.push_back(getIntersectionIndex(idxCurrent, idxNext));
+					}
+				}
+
+				if (faceLoop.size() < 3)
+				{
+					continue;
+				}
+
+				for (size_t ii = 0; ii < faceLoop.size(); ++ii)
+				{
+					std::pair<int, int> directedEdge(faceLoop[ii], faceLoop[(ii + 1) % faceLoop.size()]);
+					if (!mapDirectedEdges.insert({ directedEdge, resultFaces.size() }).second)
+					{
+						// non-manifold result
+						return false;
+					}
+				}
+				resultFaces.push_back(faceLoop);
+			}
+		}
+
+		// open edges lie in the plane. Reversed, they form the boundary loops of the caps
+		std::map<int, int> mapCapEdges;
+		for (const auto& directedEdge : mapDirectedEdges)
+		{
+			const std::pair<int, int>& edge = directedEdge.first;
+			if (mapDirectedEdges.find({ edge.second, edge.first }) != mapDirectedEdges.end())
+			{
+				continue;
+			}
+			if (!mapCapEdges.insert({ edge.second, edge.first }).second)
+			{
+				// several cap loops touch in one vertex
+				return false;
+			}
+		}
+
+		std::vector<std::vector<int> > capLoops;
+		while (mapCapEdges.size() > 0)
+		{
+			int startIndex = mapCapEdges.begin()->first;
+			int currentIndex = startIndex;
+			std::vector<int> loop;
+			while (true)
+			{
+				auto it = mapCapEdges.find(currentIndex);
+				if (it == mapCapEdges.end())
+				{
+					return false;
+				}
+				loop.push_back(currentIndex);
+				currentIndex = it->second;
+				mapCapEdges.erase(it);
+				if (currentIndex == startIndex)
+				{
+					break;
+				}
+			}
+			if (loop.size() >= 3)
+			{
+				capLoops.push_back(loop);
+			}
+		}
+
+		for (const std::vector<int>& faceLoop : resultFaces)
+		{
+			polyData->addFace(faceLoop.begin(), faceLoop.end());
+		}
+
+		if (!addCapFaces(polyData, capLoops, plane, eps))
+		{
+			return false;
+		}
+
+		shared_ptr<carve::mesh::MeshSet<3> > result(polyData->createMesh(carve::input::opts(), eps));
+		if (!result || !result->isClosed())
+		{
+			return false;
+		}
+
+		meshset = result;
+		return true;
+	}
+
+	/**\brief isInsidePolygonPrism: checks if all vertices of the meshset are inside the infinite prism of a convex polygon.
+	The polygon is given in 2D, in the xy plane of polygonPosition. For convex polygons, that means the whole meshset is inside */
+	static bool isInsidePolygonPrism(const shared_ptr<carve::mesh::MeshSet<3> >& meshset, const std::vector<vec2>& polygon, const carve::math::Matrix& polygonPositionInverse, double eps)
+	{
+		if (polygon.size() < 3)
+		{
+			return false;
+		}
+
+		// GeomUtils::signedArea is positive for clockwise loops
+		double orientation = GeomUtils::signedArea(polygon) < 0 ? 1.0 : -1.0;
+		for (size_t ii = 0; ii < polygon.size(); ++ii)
+		{
+			const vec2& p0 = polygon[ii];
+			const vec2& p1 = polygon[(ii + 1) % polygon.size()];
+			const vec2& p2 = polygon[(ii + 2) % polygon.size()];
+			double cross = (p1.x - p0.x) * (p2.y - p1.y) - (p1.y - p0.y) * (p2.x - p1.x);
+			if (cross * orientation < -eps * eps)
+			{
+				// not convex
+				return false;
+			}
+		}
+
+		for (const carve::mesh::Vertex<3>& vertex : meshset->vertex_storage)
+		{
+			vec3 localPoint = polygonPositionInverse * vertex.v;
+			for (size_t ii = 0; ii < polygon.size(); ++ii)
+			{
+				const vec2& p0 = polygon[ii];
+				const vec2& p1 = polygon[(ii + 1) % polygon.size()];
+				vec2 edge = p1 - p0;
+				double edgeLength = edge.length();
+				if (edgeLength < eps)
+				{
+					continue;
+				}
+				double cross = (edge.x * (localPoint.y - p0.y) - edge.y * (localPoint.x - p0.x)) / edgeLength;
+				if (cross * orientation < -eps)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+protected:
+	//\brief countCyclicRuns: number of maximal sequences of consecutive indices that fulfill predicate, with the last index followed by the first
+	template<typename TPredicate>
+	static size_t countCyclicRuns(const std::vector<size_t>& indices, TPredicate predicate)
+	{
+		size_t numRuns = 0;
+		bool allInRun = true;
+		for (size_t ii = 0; ii < indices.size(); ++ii)
+		{
+			size_t idxPrevious = indices[(ii + indices.size() - 1) % indices.size()];
+			if (!predicate(indices[ii]))
+			{
+				allInRun = false;
+			}
+			else if (!predicate(idxPrevious))
+			{
+				++numRuns;
+			}
+		}
+		if (allInRun && indices.size() > 0)
+		{
+			return 1;
+		}
+		return numRuns;
+	}
+
+	//\brief addCapFaces: cap loops in 2D, holes are assigned to the smallest enclosing outer loop. Caps with holes are triangulated
+	static bool addCapFaces(shared_ptr<carve::input::PolyhedronData>& polyData, const std::vector<std::vector<int> >& capLoops, const carve::geom::plane<3>& plane, double eps)
+	{
+		if (capLoops.size() == 0)
+		{
+			return true;
+		}
+
+		// the caps face the removed side, so the frame is right handed around the negated plane normal
+		vec3 capNormal = -plane.N;
+		vec3 helper = std::abs(capNormal.x) < 0.9 ? carve::geom::VECTOR(1, 0, 0) : carve::geom::VECTOR(0, 1, 0);
+		vec3 axisU = carve::geom::cross(helper, capNormal).normalized();
+		vec3 axisV = carve::geom::cross(capNormal, axisU);
+
+		struct CapLoop
+		{
+			std::vector<array2d> m_points2D;
+			const std::vector<int>* m_indices = nullptr;
+			double m_area = 0;
+			std::vector<size_t> m_holes;
+		};
+
+		std::vector<CapLoop> loops(capLoops.size());
+		for (size_t ii = 0; ii < capLoops.size(); ++ii)
+		{
+			CapLoop& loop = loops[ii];
+			loop.m_indices = &capLoops[ii];
+			for (int index : capLoops[ii])
+			{
+				const vec3& point = polyData->points[index];
+				loop.m_points2D.push_back({ dot(point, axisU), dot(point, axisV) });
+			}
+			loop.m_area = -GeomUtils::signedArea(loop.m_points2D);	// positive for counter-clockwise outer loops
+		}
+
+		for (size_t ii = 0; ii < loops.size(); ++ii)
+		{
+			if (loops[ii].m_area >= 0)
+			{
+				continue;
+			}
+
+			// hole: find the smallest outer loop that contains it
+			const array2d& holePoint = loops[ii].m_points2D[0];
+			size_t enclosingLoop = SIZE_MAX;
+			for (size_t jj = 0; jj < loops.size(); ++jj)
+			{
+				if (loops[jj].m_area <= 0)
+				{
+					continue;
+				}
+				std::vector<vec2> outerLoop;
+				for (const array2d& point : loops[jj].m_points2D)
+				{
+					outerLoop.push_back(carve::geom::VECTOR(point[0], point[1]));
+				}
+				if (GeomUtils::pointInPolySimple(outerLoop, carve::geom::VECTOR(holePoint[0], holePoint[1]), eps))
+				{
+					if (enclosingLoop == SIZE_MAX || loops[jj].m_area < loops[enclosingLoop].m_area)
+					{
+						enclosingLoop = jj;
+					}
+				}
+			}
+			if (enclosingLoop == SIZE_MAX)
+			{
+				return false;
+			}
+			loops[enclosingLoop].m_holes.push_back(ii);
+		}
+
+		for (CapLoop& loop : loops)
+		{
+			if (loop.m_area <= 0)
+			{
+				continue;
+			}
+			if (loop.m_holes.size() == 0)
+			{
+				polyData->addFace(loop.m_indices->begin(), loop.m_indices->end());
+				continue;
+			}
+
+			std::vector<std::vector<array2d> > loopsForEarcut;
+			std::vector<int> flatIndices;
+			loopsForEarcut.push_back(loop.m_points2D);
+			flatIndices.insert(flatIndices.end(), loop.m_indices->begin(), loop.m_indices->end());
+			for (size_t holeIndex : loop.m_holes)
+			{
+				loopsForEarcut.push_back(loops[holeIndex].m_points2D);
+				flatIndices.insert(flatIndices.end(), loops[holeIndex].m_indices->begin(), loops[holeIndex].m_indices->end());
+			}
+
+			std::vector<uint32_t> triangulated = mapbox::earcut<uint32_t>(loopsForEarcut);
+			if (triangulated.size() < 3)
+			{
+				return false;
+			}
+			for (size_t ii = 0; ii + 2 < triangulated.size(); ii += 3)
+			{
+				int idxA = flatIndices[triangulated[ii]];
+				int idxB = flatIndices[triangulated[ii + 1]];
+				int idxC = flatIndices[triangulated[ii + 2]];
+
+				// earcut does not keep the orientation
+				const array2d& a = getFlatPoint(loopsForEarcut, triangulated[ii]);
+				const array2d& b = getFlatPoint(loopsForEarcut, triangulated[ii + 1]);
+				const array2d& c = getFlatPoint(loopsForEarcut, triangulated[ii + 2]);
+				double cross = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+				if (cross >= 0)
+				{
+					polyData->addFace(idxA, idxB, idxC);
+				}
+				else
+				{
+					polyData->addFace(idxA, idxC, idxB);
+				}
+			}
+		}
+		return true;
+	}
+
+	static const array2d& getFlatPoint(const std::vector<std::vector<array2d> >& loops, size_t flatIndex)
+	{
+		for (const std::vector<array2d>& loop : loops)
+		{
+			if (flatIndex < loop.size())
+			{
+				return loop[flatIndex];
+			}
+			flatIndex -= loop.size();
+		}
+		return loops.back().back();
+	}
+};
@@ -20,6 +20,7 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 #include <ifcpp/geometry/MeshOps.h>
 #include "PolyInputCache3D.h"
 #include "MeshSimplifier.h"
+#include "TaskScheduler.h"
 
 void MeshSimplifier::simplifyMeshSet(shared_ptr<carve::mesh::MeshSet<3> >& meshsetInput, const GeomProcessingParams& paramsInput)
 {
@@ -295,6 +296,126 @@ void MeshSimplifier::simplifyMeshSet(shared_ptr<carve::mesh::MeshSet<3> >& meshs
 	}
 }
 
+shared_ptr<carve::mesh::MeshSet<3> > MeshSimplifier::decimateMeshSet(const shared_ptr<carve::mesh::MeshSet<3> >& meshsetInput, double minEdgeLength, const GeomProcessingParams& params)
+{
+	if (!meshsetInput)
+	{
+		return meshsetInput;
+	}
+
+	// the input meshset is shared with the full detail geometry, so the validation and the decimation work on copies
+	shared_ptr<carve::mesh::MeshSet<3> > meshsetCopy(meshsetInput->clone());
+	if (minEdgeLength <= 0)
+	{
+		return meshsetCopy;
+	}
+
+	// check if there is anything to collapse at all, to skip validation and decimation of meshes that remain the same
+	bool hasShortEdges = false;
+	const double minEdgeLength2 = minEdgeLength * minEdgeLength;
+	for (const carve::mesh::Mesh<3>* mesh : meshsetCopy->meshes)
+	{
+		for (const carve::mesh::Edge<3>* edge : mesh->closed_edges)
+		{
+			if ((edge->v2()->v - edge->v1()->v).length2() < minEdgeLength2)
+			{
+				hasShortEdges = true;
+				break;
+			}
+		}
+		if (hasShortEdges)
+		{
+			break;
+		}
+	}
+
+	if (!hasShortEdges)
+	{
+		return meshsetCopy;
+	}
+
+	MeshSetInfo infoInput(params.callbackFunc, params.ifc_entity);
+	bool validInput = MeshOps::checkMeshSetValidAndClosed(meshsetCopy, infoInput, params);
+
+	shared_ptr<carve::mesh::MeshSet<3> > meshset(meshsetCopy->clone());
+	try
+	{
+		carve::mesh::MeshSimplifier carveSimplifier(params.epsMergePoints);
+		size_t numChanges = carveSimplifier.eliminateShortEdges(meshset.get(), minEdgeLength);
+		if (numChanges == 0)
+		{
+			return meshsetCopy;
+		}
+		carveSimplifier.removeFins(meshset.get());
+		meshset->collectVertices();
+		for (carve::mesh::Mesh<3>* mesh : meshset->meshes)
+		{
+			mesh->cacheEdges();
+			mesh->recalc(params.epsMergePoints);
+		}
+	}
+	catch (carve::exception& e)
+	{
+#ifdef _DEBUG
+		std::cout << e.str() << std::endl;
+#endif
+		return meshsetCopy;
+	}
+
+	MeshSetInfo infoResult(params.callbackFunc, params.ifc_entity);
+	bool validResult = MeshOps::checkMeshSetValidAndClosed(meshset, infoResult, params);
+	if (meshset->meshes.size() == 0 || !infoResult.allPointersValid)
+	{
+		return meshsetCopy;
+	}
+
+	if (validInput && !validResult)
+	{
+		// decimation broke a closed, valid mesh
+		return meshsetCopy;
+	}
+
+	if (infoResult.openEdges.size() > infoInput.openEdges.size())
+	{
+		return meshsetCopy;
+	}
+	return meshset;
+}
+
+static bool meshesShareVertices(const carve::mesh::MeshSet<3>* meshset)
+{
+	const std::vector<carve::mesh::Vertex<3> >& vertices = meshset->vertex_storage;
+	std::vector<const carve::mesh::Mesh<3>* > vertexMesh(vertices.size(), nullptr);
+	for (const carve::mesh::Mesh<3>* mesh : meshset->meshes)
+	{
+		for (const carve::mesh::Face<3>* face : mesh->faces)
+		{
+			const carve::mesh::Edge<3>* edge = face->edge;
+			for (size_t ii = 0; ii < face->n_edges; ++ii)
+			{
+				if (edge->vert < vertices.data() || edge->vert >= vertices.data() + vertices.size())
+				{
+					// vertex not in the storage of this meshset
+					return true;
+				}
+
+				size_t index = edge->vert - vertices.data();
+
+				if (vertexMesh[index] == nullptr)
+				{
+					vertexMesh[index] = mesh;
+				}
+				else if (vertexMesh[index] != mesh)
+				{
+					return true;
+				}
+				edge = edge->next;
+			}
+		}
+	}
+	return false;
+}
+
 size_t MeshSimplifier::mergeCoplanarFacesInMeshSet(shared_ptr<carve::mesh::MeshSet<3> >& meshset, const GeomProcessingParams& paramsInput, bool shouldBeClosedManifold)
 {
 	if (!meshset)
@@ -324,57 +445,54 @@ size_t MeshSimplifier::mergeCoplanarFacesInMeshSet(shared_ptr<carve::mesh::MeshS
 	size_t numChanges = 0;
 	double volume = MeshOps::computeMeshsetVolume(meshset.get());
 
-	for (carve::mesh::Mesh<3>*mesh : meshset->meshes)
+	// meshes are independent, unless they touch in a vertex, which is moved into the plane of a merged face
+	std::vector<carve::mesh::Mesh<3>* >& vecMeshes = meshset->meshes;
+	shared_ptr<TaskScheduler> scheduler;
+	if (params.generalSettings && vecMeshes.size() > 1)
 	{
-		for (carve::mesh::Edge<3>*edge : mesh->closed_edges)
+		scheduler = params.generalSettings->m_task_scheduler;
+		if (scheduler && scheduler->getNumThreads() > 1 && meshesShareVertices(meshset.get()))
 		{
-			if (!edge)
-			{
-				continue;
-			}
-
-			carve::mesh::Edge<3>* reverseEdge = edge->rev;
-			if (!reverseEdge)
-			{
-				continue;
-			}
-
-			carve::mesh::Face<3>* face = edge->face;
-			if (!face)
-			{
-				continue;
-			}
-
-			carve::mesh::Face<3>* adjacentFace = reverseEdge->face;
-			if (!adjacentFace)
-			{
-				continue;
-			}
+			scheduler.reset();
+		}
+	}
 
-			if (adjacentFace == face)
+	if (scheduler && scheduler->getNumThreads() > 1)
+	{
+		std::vector<size_t> vecNumChanges(vecMeshes.size(), 0);
+		std::vector<std::exception_ptr> vecExceptions(vecMeshes.size());
+		scheduler->parallelFor(vecMeshes.size(), [&](size_t ii)
 			{
-				// can happen with opening
-				continue;
-			}
-
-			// re-compute face normal here
-			face->computeNormal(eps);
-			adjacentFace->computeNormal(eps);
-			const vec3 faceNormal = face->plane.N;
-			const vec3 face2Normal = adjacentFace->plane.N;
-
-			// adjacent faces have 1 as normal vector dot product
+				try
+				{
+					vecNumChanges[ii] = mergeCoplanarFacesInMesh(vecMeshes[ii], params, epsAngleMergeEdges);
+				}
+				catch (...)
+				{
+					vecExceptions[ii] = std::current_exception();
+				}
+			});
 
-			double dotProduct = dot(faceNormal, face2Normal);
-			if (std::abs(dotProduct - 1.0) < epsAngleMergeEdges)
+		for (size_t ii = 0; ii < vecMeshes.size(); ++ii)
+		{
+			if (vecExceptions[ii])
 			{
-				numChanges += removeEdgeAndMergeFaces(edge, params);
+				std::rethrow_exception(vecExceptions[ii]);
 			}
+			numChanges += vecNumChanges[ii];
+		}
+	}
+	else
+	{
+		for (carve::mesh::Mesh<3>* mesh : vecMeshes)
+		{
+			numChanges += mergeCoplanarFacesInMesh(mesh, params, epsAngleMergeEdges);
 		}
 	}
 
 	if (numChanges > 0)
 	{
+		meshset->invalidateFaceTree();
 		if (!shouldBeClosedManifold)
 		{
 			meshset = meshset_copy;
@@ -409,6 +527,113 @@ size_t MeshSimplifier::mergeCoplanarFacesInMeshSet(shared_ptr<carve::mesh::MeshS
 }
 
 
+size_t MeshSimplifier::mergeCoplanarFacesInMesh(carve::mesh::Mesh<3>* mesh, const GeomProcessingParams& params, double epsAngleMergeEdges)
+{
+	double eps = params.epsMergePoints;
+	size_t numChanges = 0;
+
+	// normal vectors are computed once per face, and again only for merged faces
+	std::unordered_map<carve::mesh::Face<3>*, vec3> mapFaceNormals;
+	auto getFaceNormal = [&mapFaceNormals, eps](carve::mesh::Face<3>* face)
+	{
+		auto it = mapFaceNormals.find(face);
+		if (it != mapFaceNormals.end())
+		{
+			return it->second;
+		}
+		face->computeNormal(eps);
+		mapFaceNormals[face] = face->plane.N;
+		return face->plane.N;
+	};
+
+	// in the order of closed_edges, as they are taken from the back
+	std::vector<carve::mesh::Edge<3>* > worklist(mesh->closed_edges.rbegin(), mesh->closed_edges.rend());
+	std::vector<carve::mesh::Face<3>* > removedFaces;
+
+	while (!worklist.empty())
+	{
+		carve::mesh::Edge<3>* edge = worklist.back();
+		worklist.pop_back();
+		if (!edge)
+		{
+			continue;
+		}
+
+		carve::mesh::Edge<3>* reverseEdge = edge->rev;
+		if (!reverseEdge)
+		{
+			continue;
+		}
+
+		carve::mesh::Face<3>* face = edge->face;
+		if (!face)
+		{
+			// edge has been removed by a previous merge
+			continue;
+		}
+
+		carve::mesh::Face<3>* adjacentFace = reverseEdge->face;
+		if (!adjacentFace)
+		{
+			continue;
+		}
+
+		if (adjacentFace == face)
+		{
+			// can happen with opening
+			continue;
+		}
+
+		// adjacent faces have 1 as normal vector dot product
+		double dotProduct = dot(getFaceNormal(face), getFaceNormal(adjacentFace));
+		if (std::abs(dotProduct - 1.0) >= epsAngleMergeEdges)
+		{
+			continue;
+		}
+
+		size_t numChangesMerge = removeEdgeAndMergeFaces(edge, params, &removedFaces);
+		if (numChangesMerge == 0)
+		{
+			continue;
+		}
+		numChanges += numChangesMerge;
+
+		carve::mesh::Face<3>* faceRemain = face->edge ? face : adjacentFace;
+		mapFaceNormals.erase(faceRemain == face ? adjacentFace : face);
+		faceRemain->computeNormal(eps);
+		mapFaceNormals[faceRemain] = faceRemain->plane.N;
+
+		// only the neighbors of the merged face can have changed. The merge can move shared vertices into the plane of faceRemain, so their normals are computed again
+		carve::mesh::Edge<3>* e = faceRemain->edge;
+		for (size_t ii = 0; ii < faceRemain->n_edges; ++ii)
+		{
+			if (e->rev && e->rev->face != faceRemain)
+			{
+				if (e->rev->face)
+				{
+					mapFaceNormals.erase(e->rev->face);
+				}
+				worklist.push_back(e);
+			}
+			e = e->next;
+		}
+	}
+
+	if (removedFaces.size() > 0)
+	{
+		std::unordered_set<carve::mesh::Face<3>* > setRemovedFaces(removedFaces.begin(), removedFaces.end());
+		auto itRemove = std::remove_if(mesh->faces.begin(), mesh->faces.end(), [&setRemovedFaces](carve::mesh::Face<3>* f) { return setRemovedFaces.find(f) != setRemovedFaces.end(); });
+		mesh->faces.erase(itRemove, mesh->faces.end());
+		for (carve::mesh::Face<3>* f : removedFaces)
+		{
+			delete f;
+		}
+		mesh->cacheEdges();
+	}
+
+	return numChanges;
+}
+
 size_t MeshSimplifier::mergeAlignedEdges(shared_ptr<carve::mesh::MeshSet<3> >& meshset, GeomProcessingParams& params)
 {
 #ifdef _DEBUG
@@ -463,10 +688,6 @@ size_t MeshSimplifier::mergeAlignedEdges(shared_ptr<carve::mesh::MeshSet<3> >& m
 								carve::mesh::Vertex<3>* vertex2 = edge->v2();
 								carve::mesh::Vertex<3>* vertex3 = edge->next->v2();
 
-								std::unordered_set<carve::mesh::Edge<3>* > setEdges;
-								getEdgesOnVertex(mesh, vertex2, setEdges);
-								size_t numEdgesOnVertex = setEdges.size();
-
 								const carve::geom::vector<3>& p1 = vertex1->v;
 								const carve::geom::vector<3>& p2 = vertex2->v;
 								const carve::geom::vector<3>& p3 = vertex3->v;
@@ -480,6 +701,8 @@ size_t MeshSimplifier::mergeAlignedEdges(shared_ptr<carve::mesh::MeshSet<3> >& m
 								vec4 color1(0.4, 0.45, 0.45, 1.);
 								if (params.debugDump)
 								{
+									std::unordered_set<carve::mesh::Edge<3>* > setEdges;
+									getEdgesOnVertex(mesh, vertex2, setEdges);
 									for (auto edgeOnVertex : setEdges)
 									{
 										const carve::geom::vector<3>& p1 = edgeOnVertex->v1()->v;
@@ -513,9 +736,6 @@ size_t MeshSimplifier::mergeAlignedEdges(shared_ptr<carve::mesh::MeshSet<3> >& m
 									}
 #endif
 
-									std::unordered_set<carve::mesh::Edge<3>* > setEdgePointersToRemovedEdge;
-									std::unordered_set<carve::mesh::Face<3>* > setFacePointersToRemovedEdge;
-									getPointerToEdge(mesh, edgeRemove, setEdgePointersToRemovedEdge, setFacePointersToRemovedEdge);
 									size_t numVertexChanges = removePointerToVertex(mesh, vertex2, vertex1);
 									edge = edgeRemove->removeEdge();  // returns ->next
 									carve::geom::vector<3> distanceV1 = edge->v1()->v - p1;
@@ -524,9 +744,8 @@ size_t MeshSimplifier::mergeAlignedEdges(shared_ptr<carve::mesh::MeshSet<3> >& m
 									//double epsMinFaceArea = params.minFaceArea;// *0.001;
 									//MeshOps::removeZeroAreaFacesInMesh(mesh, epsMinFaceArea, eps, dumpFaces);
 
+									// edges and face planes are updated once for all removed edges, see below
 									++numEdgesRemoved;
-									mesh->cacheEdges();
-									mesh->recalc(params.epsMergePoints);
 
 									//      edge->rev->next         edge->rev                                    edge->next->rev  
 									//  <--------------------v1<---------------------------------------------v2<------------------------
@@ -534,6 +753,8 @@ size_t MeshSimplifier::mergeAlignedEdges(shared_ptr<carve::mesh::MeshSet<3> >& m
 									//     edge->prev               edge                                           edge->next    
 
 #ifdef _DEBUG
+									mesh->cacheEdges();
+									mesh->recalc(params.epsMergePoints);
 									if (params.debugDump)
 									{
 										vec4 color(0.4, 0.45, 0.45, 1.);
@@ -642,6 +863,7 @@ size_t MeshSimplifier::mergeAlignedEdges(shared_ptr<carve::mesh::MeshSet<3> >& m
 		}
 #endif
 
+		meshset->invalidateFaceTree();
 		for (auto mesh : meshset->meshes)
 		{
 			mesh->cacheEdges();
@@ -663,7 +885,7 @@ size_t MeshSimplifier::mergeAlignedEdges(shared_ptr<carve::mesh::MeshSet<3> >& m
 	return numEdgesRemoved;
 }
 
-size_t MeshSimplifier::removeEdgeAndMergeFaces(carve::mesh::Edge<3>* edgeIn, const GeomProcessingParams& params)
+size_t MeshSimplifier::removeEdgeAndMergeFaces(carve::mesh::Edge<3>* edgeIn, const GeomProcessingParams& params, std::vector<carve::mesh::Face<3>* >* removedFaces)
 {
 	double eps = params.epsMergePoints;
 	carve::mesh::Face<3>* face = edgeIn->face;
@@ -818,8 +1040,16 @@ size_t MeshSimplifier::removeEdgeAndMergeFaces(carve::mesh::Edge<3>* edgeIn, con
 		e = e->next;
 	}
 
-	numChanges += removeFaceFromMesh(faceRemove);
-	delete faceRemove;
+	if (removedFaces)
+	{
+		removedFaces->push_back(faceRemove);
+		++numChanges;
+	}
+	else
+	{
+		numChanges += removeFaceFromMesh(faceRemove);
+		delete faceRemove;
+	}
 	++numFacesDeleted;
 
 	if (!faceRemain)
@@ -828,18 +1058,21 @@ size_t MeshSimplifier::removeEdgeAndMergeFaces(carve::mesh::Edge<3>* edgeIn, con
 	}
 
 	auto mesh = faceRemain->mesh;
+#ifdef _DEBUG
 	try
 	{
 		faceRemain->edge->validateLoop();
 	}
 	catch (carve::exception& e)
 	{
-#ifdef _DEBUG
 		std::cout << "validateLoop failed: " << e.str();
-#endif
 	}
+#endif
 
-	mesh->cacheEdges();
+	if (!removedFaces)
+	{
+		mesh->cacheEdges();
+	}
 	//mesh->recalc(eps);
 	++numChanges;
 
@@ -876,6 +1109,11 @@ size_t MeshSimplifier::removeEdgeAndMergeFaces(carve::mesh::Edge<3>* edgeIn, con
 				}
 #endif
 				vertex->v = pointOnPlane;
+				if (mesh)
+				{
+					// volume, area and bounding box of the mesh are cached, see Mesh::updateMetrics
+					mesh->resetVolume();
+				}
 
 				// TODO: average out current vertices between all faces that are connected
 				// map<vertex, std::vector<face>>
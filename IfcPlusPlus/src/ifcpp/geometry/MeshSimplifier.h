@@ -38,6 +38,14 @@ public:
 
 	static size_t mergeAlignedEdges(shared_ptr<carve::mesh::MeshSet<3> >& meshset, GeomProcessingParams& params);
 
+	/**
+	* @brief decimateMeshSet: coarser copy of a meshset for a level of detail. Edges shorter than minEdgeLength are collapsed, starting with the shortest edge
+	* @param meshset				input meshset, not modified
+	* @param minEdgeLength			edges shorter than this are collapsed
+	* @return the decimated meshset, or an unchanged copy of the input if nothing could be collapsed or the result is not valid (or not closed while the input is closed). The input meshset is never returned
+	*/
+	static shared_ptr<carve::mesh::MeshSet<3> > decimateMeshSet(const shared_ptr<carve::mesh::MeshSet<3> >& meshset, double minEdgeLength, const GeomProcessingParams& params);
+
 	static size_t removePointerToVertex(carve::mesh::Mesh<3>* mesh, carve::mesh::Vertex<3>* vertRemove, carve::mesh::Vertex<3>* vertReplace)
 	{
 		size_t numChanges = 0;
@@ -136,7 +144,19 @@ public:
 
 	static size_t mergeCoplanarFacesInMeshSet(shared_ptr<carve::mesh::MeshSet<3> >& meshset, const GeomProcessingParams& paramsInput, bool shouldBeClosedManifold);
 
-	static size_t removeEdgeAndMergeFaces(carve::mesh::Edge<3>* edgeIn, const GeomProcessingParams& params);
+	/**
+	* @brief mergeCoplanarFacesInMesh: merges adjacent faces with parallel normal vectors. All closed edges are checked once, after a merge only the edges of the merged face are checked again
+	* @param mesh					Carve mesh, faces are merged in place
+	* @param epsAngleMergeEdges		faces are merged if the dot product of their normal vectors differs less than this from 1
+	* @return number of changes
+	*/
+	static size_t mergeCoplanarFacesInMesh(carve::mesh::Mesh<3>* mesh, const GeomProcessingParams& params, double epsAngleMergeEdges);
+
+	/**
+	* @brief removeEdgeAndMergeFaces: merges the two faces of edgeIn
+	* @param removedFaces			if nullptr, the removed face is deleted and the edges of the mesh are cached again. Otherwise, the removed face is appended, and the caller has to do that
+	*/
+	static size_t removeEdgeAndMergeFaces(carve::mesh::Edge<3>* edgeIn, const GeomProcessingParams& params, std::vector<carve::mesh::Face<3>* >* removedFaces = nullptr);
 
 
 	static size_t removeFaceFromMesh(carve::mesh::Face<3>* fx)
@@ -17,7 +17,10 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 
 #pragma once
 
+#include <mutex>
 #include <set>
+#include <shared_mutex>
+#include <unordered_map>
 #include <unordered_set>
 #include <ifcpp/model/BasicTypes.h>
 #include <ifcpp/model/UnitConverter.h>
@@ -49,6 +52,14 @@ using namespace IFC4X3;
 
 class PlacementConverter : public StatusCallback
 {
+protected:
+	// converted placement chains, keyed by tag of the IfcObjectPlacement. Each entry holds the transform of the placement itself, followed by the transforms of all
+	// placements it is relative to. Products on the same storey share the storey->building->site chain instead of converting it again.
+	// The chain is cached instead of the composed matrix, because ProductShapeData::getRelativeTransform skips the placements that a product and its openings share.
+	// Chains of placements that are part of a cyclic PlacementRelTo reference are incomplete and not cached
+	std::unordered_map<int, shared_ptr<std::vector<shared_ptr<TransformData> > > > m_placement_cache;
+	std::shared_mutex m_placement_cache_mutex;
+
 public:
 	shared_ptr<UnitConverter>	m_unit_converter;
 
@@ -57,6 +68,12 @@ public:
 
 	}
 
+	void clearPlacementCache()
+	{
+		std::unique_lock<std::shared_mutex> lock( m_placement_cache_mutex );
+		m_placement_cache.clear();
+	}
+
 	void convertIfcAxis2Placement2D( const shared_ptr<IfcAxis2Placement2D>& axis2placement2d, shared_ptr<TransformData>& resultingTransform, bool only_rotation = false )
 	{
 		const double length_factor = m_unit_converter->getLengthInMeterFactor();
@@ -443,24 +460,52 @@ public:
 		{
 			return;
 		}
+
+		bool cycle_detected = false;
+		shared_ptr<std::vector<shared_ptr<TransformData> > > placement_transforms = getPlacementTransforms( ifc_object_placement, placement_already_applied, only_rotation, cycle_detected );
+		if( placement_transforms )
+		{
+			// addTransform inserts at the front, so start with the outermost placement
+			for( auto it = placement_transforms->rbegin(); it != placement_transforms->rend(); ++it )
+			{
+				shared_ptr<TransformData> transform = *it;
+				product_data->addTransform( transform );
+			}
+		}
+	}
+
+	/*\brief getPlacementTransforms: converts the placement and all placements it is relative to. The result starts with the given placement, followed by its parents.
+	* Results are cached per placement tag, the returned TransformData objects are shared and must not be modified.
+	* cycle_detected is set if the chain ends at a placement that was already applied. Such a chain is incomplete and not cached
+	**/
+	shared_ptr<std::vector<shared_ptr<TransformData> > > getPlacementTransforms( const shared_ptr<IfcObjectPlacement>& ifc_object_placement, 
+		std::unordered_set<IfcObjectPlacement*>& placement_already_applied, bool only_rotation, bool& cycle_detected )
+	{
+		const int placement_tag = ifc_object_placement->m_tag;
+		const bool use_cache = !only_rotation && placement_tag >= 0;
+		if( use_cache )
+		{
+			std::shared_lock<std::shared_mutex> lock( m_placement_cache_mutex );
+			auto it_find = m_placement_cache.find( placement_tag );
+			if( it_find != m_placement_cache.end() )
+			{
+				return it_find->second;
+			}
+		}
+
 		// prevent cyclic relative placement
 		IfcObjectPlacement* placement_ptr = ifc_object_placement.get();
 		if( placement_already_applied.find( placement_ptr ) != placement_already_applied.end() )
 		{
-			return;
+			cycle_detected = true;
+			return shared_ptr<std::vector<shared_ptr<TransformData> > >();
 		}
 		placement_already_applied.insert( placement_ptr );
 
+		shared_ptr<std::vector<shared_ptr<TransformData> > > placement_transforms = make_shared<std::vector<shared_ptr<TransformData> > >();
 		shared_ptr<IfcLocalPlacement> local_placement = dynamic_pointer_cast<IfcLocalPlacement>( ifc_object_placement );
 		if( local_placement )
 		{
-			if( local_placement->m_PlacementRelTo )
-			{
-				// placement is relative to other placement
-				shared_ptr<IfcObjectPlacement> rel_to_placement = local_placement->m_PlacementRelTo;
-				convertIfcObjectPlacement( rel_to_placement, product_data, placement_already_applied, only_rotation );
-			}
-
 			shared_ptr<IfcAxis2Placement> relative_axis2placement_select = local_placement->m_RelativePlacement;
 			if( relative_axis2placement_select )
 			{
@@ -470,13 +515,27 @@ public:
 				{
 					shared_ptr<TransformData> relative_placement_matrix;
 					convertIfcPlacement( relative_placement, relative_placement_matrix, only_rotation );
-					product_data->addTransform( relative_placement_matrix );
+					if( relative_placement_matrix )
+					{
+						placement_transforms->push_back( relative_placement_matrix );
+					}
 				}
 				else
 				{
 					messageCallback( "unhandled placement", StatusCallback::MESSAGE_TYPE_WARNING, __FUNC__, local_placement.get() );
 				}
 			}
+
+			if( local_placement->m_PlacementRelTo )
+			{
+				// placement is relative to other placement
+				shared_ptr<IfcObjectPlacement> rel_to_placement = local_placement->m_PlacementRelTo;
+				shared_ptr<std::vector<shared_ptr<TransformData> > > rel_to_transforms = getPlacementTransforms( rel_to_placement, placement_already_applied, only_rotation, cycle_detected );
+				if( rel_to_transforms )
+				{
+					std::copy( rel_to_transforms->begin(), rel_to_transforms->end(), std::back_inserter( *placement_transforms ) );
+				}
+			}
 		}
 		else if( dynamic_pointer_cast<IfcGridPlacement>( ifc_object_placement ) )
 		{
@@ -494,6 +553,15 @@ public:
 
 			//IfcGridPlacementDirectionSelect* ref_direction = grid_placement->m_PlacementRefDirection.get();	//optional
 		}
+
+		if( use_cache && !cycle_detected )
+		{
+			// if another thread was faster, use its result, so that all products share the same TransformData objects
+			std::unique_lock<std::shared_mutex> lock( m_placement_cache_mutex );
+			auto it_inserted = m_placement_cache.insert( { placement_tag, placement_transforms } );
+			return it_inserted.first->second;
+		}
+		return placement_transforms;
 	}
 
 	void convertTransformationOperator( const shared_ptr<IfcCartesianTransformationOperator>& transform_operator, shared_ptr<TransformData>& resultingTransform )
@@ -17,20 +17,12 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 
 #pragma once
 
+#include <cmath>
 #include <vector>
 #include <unordered_set>
+#include <ifcpp/model/BasicTypes.h>
 #include "IncludeCarveHeaders.h"
 
-// hash function for vec3
-static uint32_t Vec3Hash(const vec3& v, double epsilon) {
-	//  uint32_t is enough for hash. 
-	uint32_t hx = (uint32_t)std::hash<double>{}(v.x / epsilon);
-	uint32_t hy = (uint32_t)std::hash<double>{}(v.y / epsilon);
-	uint32_t hz = (uint32_t)std::hash<double>{}(v.z / epsilon);
-	return (uint32_t)hx ^ (hy << 1) ^ (hz << 2);
-}
-
-
 // equality function for vec3
 static bool Vec3Equal(const vec3& lhs, const vec3& rhs, double epsilon) {
 	return std::fabs(lhs.x - rhs.x) < epsilon &&
@@ -38,49 +30,159 @@ static bool Vec3Equal(const vec3& lhs, const vec3& rhs, double epsilon) {
 		std::fabs(lhs.z - rhs.z) < epsilon;
 }
 
+/**
+* \brief Class PolyInputCache3D: collects points and faces for a carve::input::PolyhedronData. Points closer than epsilon (in each coordinate) are merged.
+* Points are sorted into grid cells of size 4*epsilon. A point can only be merged with points in the cells touched by its epsilon box,
+* which is one cell in most cases. Cells are stored in an open addressing hash table (linear probing), without allocations per point.
+*/
 class PolyInputCache3D {
-public:
+protected:
+	struct CellEntry
+	{
+		uint64_t cellHash = 0;
+		uint32_t pointIndex = UINT32_MAX;	// UINT32_MAX: empty slot
+	};
+
+	std::vector<CellEntry> m_cellTable;
+	size_t m_numCellEntries = 0;
+	double m_cellSize = 4e-6;
 
-	// uint32 max value is 14757395217560929096, this should be enough for indexing points
-	std::unordered_map<uint32_t, uint32_t> m_hashToIndexMap;
+public:
 	shared_ptr<carve::input::PolyhedronData> m_poly_data;
 	double epsilon;
 
 	PolyInputCache3D(double eps = 1e-6) : epsilon(eps) {
 		m_poly_data = shared_ptr<carve::input::PolyhedronData>(new carve::input::PolyhedronData());
+		m_cellSize = 4.0 * eps;
+	}
+
+	//\brief reservePoints: allocates memory for the expected number of points up front
+	void reservePoints(size_t numPoints) {
+		m_poly_data->points.reserve(numPoints);
+		size_t tableSize = 16;
+		while (tableSize < numPoints * 2) {
+			tableSize *= 2;
+		}
+		if (tableSize > m_cellTable.size()) {
+			rehash(tableSize);
+		}
 	}
 
 	// Adds a point to the cache. Returns the index of the existing or newly inserted point.
 	uint32_t addPoint(const vec3& pt) {
-		uint32_t hash = Vec3Hash(pt, epsilon);
 		std::vector<vec3>& pointList = m_poly_data->points;
 
-		auto it = m_hashToIndexMap.find(hash);
-		if (it != m_hashToIndexMap.end()) {
-			// If the hash exists, check if the point matches (in case of hash collision)
-			uint32_t index = it->second;
-			if (Vec3Equal(pointList[index], pt, epsilon)) {
-				return index;
+		if (isInGridRange(pt)) {
+			// check all cells that are touched by the epsilon box around the point. If several existing points are within epsilon, take the first one
+			const int64_t minX = cellCoord(pt.x - epsilon), maxX = cellCoord(pt.x + epsilon);
+			const int64_t minY = cellCoord(pt.y - epsilon), maxY = cellCoord(pt.y + epsilon);
+			const int64_t minZ = cellCoord(pt.z - epsilon), maxZ = cellCoord(pt.z + epsilon);
+			uint32_t foundIndex = UINT32_MAX;
+			if (m_numCellEntries > 0) {
+				for (int64_t cx = minX; cx <= maxX; ++cx) {
+					for (int64_t cy = minY; cy <= maxY; ++cy) {
+						for (int64_t cz = minZ; cz <= maxZ; ++cz) {
+							const uint64_t cellHash = hashCell(cx, cy, cz);
+							const size_t mask = m_cellTable.size() - 1;
+							for (size_t slot = cellHash & mask; m_cellTable[slot].pointIndex != UINT32_MAX; slot = (slot + 1) & mask) {
+								const CellEntry& entry = m_cellTable[slot];
+								if (entry.cellHash == cellHash && entry.pointIndex < foundIndex) {
+									if (Vec3Equal(pointList[entry.pointIndex], pt, epsilon)) {
+										foundIndex = entry.pointIndex;
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+
+			if (foundIndex != UINT32_MAX) {
+				return foundIndex;
 			}
+
+			uint32_t newIndex = static_cast<uint32_t>(pointList.size());
+			pointList.push_back(pt);
+			insertCellEntry(hashCell(cellCoord(pt.x), cellCoord(pt.y), cellCoord(pt.z)), newIndex);
+			return newIndex;
 		}
 
-		// Otherwise, add the new point
+		// invalid coordinates or epsilon, no merging
 		uint32_t newIndex = static_cast<uint32_t>(pointList.size());
 		pointList.push_back(pt);
-		m_hashToIndexMap[hash] = newIndex;
-
 		return newIndex;
 	}
 
 	void clearPointCache()
 	{
-		m_hashToIndexMap.clear();
+		m_cellTable.clear();
+		m_numCellEntries = 0;
 		m_poly_data->points.clear();
 	}
 
+protected:
+	bool isInGridRange(const vec3& pt) const {
+		if (!(m_cellSize > 0)) {
+			return false;
+		}
+		// cell coordinates have to fit into int64_t
+		const double maxCoord = 1e18 * m_cellSize;
+		return std::abs(pt.x) < maxCoord && std::abs(pt.y) < maxCoord && std::abs(pt.z) < maxCoord;
+	}
+
+	int64_t cellCoord(double value) const {
+		return static_cast<int64_t>(std::floor(value / m_cellSize));
+	}
+
+	static uint64_t hashCell(int64_t cx, int64_t cy, int64_t cz) {
+		uint64_t h = uint64_t(cx) * 0x9E3779B97F4A7C15ull;
+		h ^= uint64_t(cy) * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+		h ^= uint64_t(cz) * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+		// finalizer of splitmix64, to spread neighbouring cells over the table
+		h ^= h >> 30;
+		h *= 0xBF58476D1CE4E5B9ull;
+		h ^= h >> 27;
+		h *= 0x94D049BB133111EBull;
+		h ^= h >> 31;
+		return h;
+	}
+
+	void insertCellEntry(uint64_t cellHash, uint32_t pointIndex) {
+		// keep the load factor below 0.5, so that probe sequences stay short
+		if ((m_numCellEntries + 1) * 2 > m_cellTable.size()) {
+			rehash(std::max(size_t(16), m_cellTable.size() * 2));
+		}
+		const size_t mask = m_cellTable.size() - 1;
+		size_t slot = cellHash & mask;
+		while (m_cellTable[slot].pointIndex != UINT32_MAX) {
+			slot = (slot + 1) & mask;
+		}
+		m_cellTable[slot].cellHash = cellHash;
+		m_cellTable[slot].pointIndex = pointIndex;
+		++m_numCellEntries;
+	}
+
+	void rehash(size_t tableSize) {
+		std::vector<CellEntry> oldTable;
+		oldTable.swap(m_cellTable);
+		m_cellTable.resize(tableSize);
+		const size_t mask = tableSize - 1;
+		for (const CellEntry& entry : oldTable) {
+			if (entry.pointIndex != UINT32_MAX) {
+				size_t slot = entry.cellHash & mask;
+				while (m_cellTable[slot].pointIndex != UINT32_MAX) {
+					slot = (slot + 1) & mask;
+				}
+				m_cellTable[slot] = entry;
+			}
+		}
+	}
+
+public:
 	void copyOtherPolyData(shared_ptr<carve::input::PolyhedronData>& other)
 	{
 		shared_ptr<carve::mesh::MeshSet<3> > meshset(other->createMesh(carve::input::opts(), epsilon));
+		reservePoints(m_poly_data->points.size() + other->points.size());
 
 		for (size_t i = 0; i < meshset->meshes.size(); ++i)
 		{
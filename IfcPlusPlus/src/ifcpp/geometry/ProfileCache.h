@@ -17,21 +17,35 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 
 #pragma once
 
-#include <map>
+#include <future>
+#include <mutex>
+#include <unordered_map>
 #include <ifcpp/model/BasicTypes.h>
 #include <ifcpp/model/StatusCallback.h>
 #include "ProfileConverter.h"
 #include "CurveConverter.h"
 #include "SplineConverter.h"
+#include "GeometryProfiler.h"
 
+/**
+*\brief Class ProfileCache: converts each IfcProfileDef once, and shares the result between all products using it.
+* The cache is split into shards with separate locks, so that threads requesting different profiles do not block each other.
+* If several threads request the same profile at the same time, only the first one computes it, the others wait for its result.
+*/
 class ProfileCache : public StatusCallback
 {
 protected:
+	static const size_t NUM_SHARDS = 16;
+
+	struct ProfileCacheShard
+	{
+		std::unordered_map<int64_t, std::shared_future<shared_ptr<ProfileConverter> > > m_profiles;
+		std::mutex m_mutex;
+	};
+
 	shared_ptr<CurveConverter>					m_curve_converter;
 	shared_ptr<SplineConverter>					m_spline_converter;
-	std::map<int,shared_ptr<ProfileConverter> >	m_profile_cache;
-
-	std::mutex m_writelock_profile_cache;
+	ProfileCacheShard							m_shards[NUM_SHARDS];
 
 public:
 	ProfileCache( shared_ptr<CurveConverter>& cc, shared_ptr<SplineConverter>& sc )
@@ -45,7 +59,11 @@ public:
 
 	void clearProfileCache()
 	{
-		m_profile_cache.clear();
+		for( ProfileCacheShard& shard : m_shards )
+		{
+			std::lock_guard<std::mutex> lock( shard.m_mutex );
+			shard.m_profiles.clear();
+		}
 	}
 
 	shared_ptr<ProfileConverter> getProfileConverter( const shared_ptr<IfcProfileDef>& ifc_profile, bool simplifyPaths)
@@ -62,45 +80,81 @@ public:
 			throw BuildingException( strs.str().c_str(), __FUNC__ );
 		}
 
-		auto it_profile_cache = m_profile_cache.find( profile_id );
-		if( it_profile_cache != m_profile_cache.end() )
+		const int64_t key = int64_t(profile_id) * 2 + (simplifyPaths ? 1 : 0);
+		ProfileCacheShard& shard = m_shards[size_t(profile_id) % NUM_SHARDS];
+
+		std::shared_future<shared_ptr<ProfileConverter> > future_profile;
+		std::promise<shared_ptr<ProfileConverter> > promise_profile;
+		bool computeProfile = false;
 		{
-			if( it_profile_cache->second->m_simplifyPathsByDefault == simplifyPaths )
+			std::lock_guard<std::mutex> lock( shard.m_mutex );
+			auto it_profile_cache = shard.m_profiles.find( key );
+			if( it_profile_cache != shard.m_profiles.end() )
+			{
+				future_profile = it_profile_cache->second;
+			}
+			else
 			{
-				return it_profile_cache->second;
+				future_profile = promise_profile.get_future().share();
+				shard.m_profiles[key] = future_profile;
+				computeProfile = true;
 			}
 		}
 
-		double eps = m_curve_converter->getGeomSettings()->getEpsilonMergePoints();
-		int numVerticesPerCircleDefault = m_curve_converter->getGeomSettings()->getNumVerticesPerCircle();
-		int numVerticesPerCircle = numVerticesPerCircleDefault;
+		GeometryProfiler* profiler = m_curve_converter->getGeomSettings()->m_profiler.get();
+		if( profiler )
+		{
+			std::atomic<size_t>& counter = computeProfile ? profiler->m_profile_cache_misses : profiler->m_profile_cache_hits;
+			counter.fetch_add( 1, std::memory_order_relaxed );
+		}
+
+		if( computeProfile )
+		{
+			try
+			{
+				promise_profile.set_value( computeProfileConverter( ifc_profile, simplifyPaths ) );
+			}
+			catch( ... )
+			{
+				// threads waiting for this profile get the same exception
+				promise_profile.set_exception( std::current_exception() );
+			}
+		}
+
+		// throws the exception of computeProfileConverter, if any
+		return future_profile.get();
+	}
+
+protected:
+	/**\brief computeProfileConverter: computes the profile. In case of self-intersections, the profile is computed again with a higher number of vertices per circle.
+	The tessellation density of a retry is passed through separate settings for this request, the shared GeometrySettings are not modified */
+	shared_ptr<ProfileConverter> computeProfileConverter( const shared_ptr<IfcProfileDef>& ifc_profile, bool simplifyPaths )
+	{
+		shared_ptr<GeometrySettings> geom_settings = m_curve_converter->getGeomSettings();
+		double eps = geom_settings->getEpsilonMergePoints();
+		int numVerticesPerCircle = geom_settings->getNumVerticesPerCircle();
 		shared_ptr<ProfileConverter> profile_converter = shared_ptr<ProfileConverter>(new ProfileConverter(m_curve_converter, m_spline_converter));
 		profile_converter->m_simplifyPathsByDefault = simplifyPaths;
 		profile_converter->computeProfile(ifc_profile);
 
-		for (size_t retryCount = 0; retryCount < 5; ++retryCount)
+		// up to 5 retries, the last result is checked as well, to report remaining self-intersections
+		std::vector<std::pair<size_t, size_t> > intersectingSegments;
+		for (size_t retryCount = 0; retryCount <= 5; ++retryCount)
 		{
-			bool selfintersectionFound = false;
 			const std::vector<std::vector<vec2> >& coords = profile_converter->getCoordinates();
-
-			if (coords.size() > 5000)
-			{
-				// too slow
-				continue;
-			}
+			intersectingSegments.clear();
 
 			for (size_t ii = 0; ii < coords.size(); ++ii)
 			{
 				const std::vector<vec2>& loop = coords[ii];
-				if (GeomUtils::isPolygonSelfIntersecting(loop, eps))
+				GeomUtils::findPolygonSelfIntersections(loop, eps, intersectingSegments, true);
+				if (intersectingSegments.size() > 0)
 				{
 #ifdef _DEBUG
 					vec4 color(0.4, 0.6, 0.6, 1.0);
 					GeomDebugDump::dumpLocalCoordinateSystem();
 					GeomDebugDump::dumpPolyline(loop, color, 1.0, true, false);
 #endif
-
-					selfintersectionFound = true;
 					break;
 				}
 			}
@@ -108,12 +162,13 @@ public:
 			// TODO: check if discretization changed number of points in polygon. If not, break
 			// TODO: performance improvement: throw exception in earcut upon self intersection detection. catch and restart higher up
 
-			if (selfintersectionFound)
+			if (intersectingSegments.size() > 0 && retryCount < 5)
 			{
-				numVerticesPerCircle += 10;
-				m_curve_converter->getGeomSettings()->setNumVerticesPerCircle(numVerticesPerCircle);
 				// retry with higher accuracy
-				profile_converter = shared_ptr<ProfileConverter>(new ProfileConverter(m_curve_converter, m_spline_converter));
+				numVerticesPerCircle += 10;
+				shared_ptr<CurveConverter> curve_converter_retry = createCurveConverter(numVerticesPerCircle);
+				profile_converter = shared_ptr<ProfileConverter>(new ProfileConverter(curve_converter_retry, m_spline_converter));
+				profile_converter->m_simplifyPathsByDefault = simplifyPaths;
 				profile_converter->computeProfile(ifc_profile);
 			}
 			else
@@ -121,11 +176,34 @@ public:
 				break;
 			}
 		}
-		m_curve_converter->getGeomSettings()->setNumVerticesPerCircle(numVerticesPerCircleDefault);
 
-		std::lock_guard<std::mutex> lock(m_writelock_profile_cache);
-		m_profile_cache[profile_id] = profile_converter;
+		if (intersectingSegments.size() > 0)
+		{
+			std::stringstream strs;
+			strs << "profile is self-intersecting, segment " << intersectingSegments[0].first << " crosses segment " << intersectingSegments[0].second;
+			messageCallback(strs.str(), StatusCallback::MESSAGE_TYPE_MINOR_WARNING, __FUNC__, ifc_profile.get());
+		}
 
 		return profile_converter;
 	}
+
+	//\brief createCurveConverter: CurveConverter with a copy of the geometry settings, using the given number of vertices per circle
+	shared_ptr<CurveConverter> createCurveConverter( int numVerticesPerCircle )
+	{
+		shared_ptr<GeometrySettings> geom_settings( new GeometrySettings( m_curve_converter->getGeomSettings() ) );
+		geom_settings->setNumVerticesPerCircle( numVerticesPerCircle );
+		if( geom_settings->isAdaptiveTessellation() )
+		{
+			// adaptive segment counts do not depend on the number of vertices per circle, so the tolerances are refined in the same ratio.
+			// The chordal deviation decreases with the square of the segment angle
+			double factor = double( m_curve_converter->getGeomSettings()->getNumVerticesPerCircle() ) / double( numVerticesPerCircle );
+			geom_settings->setTessellationTolerance( geom_settings->getMaxChordalDeviation()*factor*factor, geom_settings->getMaxAngleDeviation()*factor );
+		}
+		shared_ptr<PlacementConverter> placement_converter = m_curve_converter->getPlacementConverter();
+		shared_ptr<PointConverter> point_converter = m_curve_converter->getPointConverter();
+		shared_ptr<SplineConverter> spline_converter = m_curve_converter->getSplineConverter();
+		shared_ptr<CurveConverter> curve_converter( new CurveConverter( geom_settings, placement_converter, point_converter, spline_converter ) );
+		curve_converter->setMessageTarget( this );
+		return curve_converter;
+	}
 };
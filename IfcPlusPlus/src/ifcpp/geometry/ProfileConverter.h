@@ -582,12 +582,7 @@ public:
 					return;
 				}
 				int num_segments = gs->getNumVerticesPerCircleWithRadius(radius);
-				double angle = 0;
-				for( int i = 0; i < num_segments; ++i )
-				{
-					outer_loop.push_back( carve::geom::VECTOR( ( radius * cos( angle ) ), ( radius * sin( angle ) ) ) );
-					angle += 2.0*M_PI / double( num_segments );
-				}
+				GeomUtils::addEllipseArcPoints( outer_loop, radius, radius, 0, 2.0*M_PI / double( num_segments ), num_segments, 0, 0 );
 				paths.push_back( outer_loop );
 
 				// CircleHollow
@@ -595,15 +590,10 @@ public:
 				shared_ptr<IfcCircleHollowProfileDef> hollow = dynamic_pointer_cast<IfcCircleHollowProfileDef>( profile );
 				if( hollow )
 				{
-					angle = 0;
 					radius -= hollow->m_WallThickness->m_value*length_factor;
 
 					int num_segments2 = gs->getNumVerticesPerCircleWithRadius(radius);
-					for( int i = 0; i < num_segments2; ++i )
-					{
-						inner_loop.push_back( carve::geom::VECTOR( ( radius * cos( angle ) ), ( radius * sin( angle ) ) ) );
-						angle += 2.0*M_PI / double( num_segments2 );
-					}
+					GeomUtils::addEllipseArcPoints( inner_loop, radius, radius, 0, 2.0*M_PI / double( num_segments2 ), num_segments2, 0, 0 );
 					paths.push_back( inner_loop );
 				}
 			}
@@ -621,12 +611,7 @@ public:
 					double x_radius = ellipse_profile_def->m_SemiAxis1->m_value*length_factor;
 					double y_radius = ellipse_profile_def->m_SemiAxis2->m_value*length_factor;
 					int num_segments = gs->getNumVerticesPerCircleWithRadius(std::max(x_radius, y_radius));
-					double angle = 0;
-					for( int i = 0; i < num_segments; ++i )
-					{
-						outer_loop.push_back( carve::geom::VECTOR( ( x_radius * cos( angle ) ), ( y_radius * sin( angle ) ) ) );
-						angle += 2.0*M_PI / double( num_segments );
-					}
+					GeomUtils::addEllipseArcPoints( outer_loop, x_radius, y_radius, 0, 2.0*M_PI / double( num_segments ), num_segments, 0, 0 );
 					paths.push_back( outer_loop );
 				}
 			}
@@ -1156,7 +1141,11 @@ public:
 			return;
 		}
 		//int num_segments = (int)( std::abs( opening_angle ) / ( 2.0*M_PI )*gs->getNumVerticesPerCircle() ); // TODO: adapt to model size and complexity
-		if( num_segments < gs->getMinNumVerticesPerArc() )
+		if( gs->isAdaptiveTessellation() )
+		{
+			num_segments = gs->getNumVerticesPerArc( radius, opening_angle ) - 1;
+		}
+		else if( num_segments < gs->getMinNumVerticesPerArc() )
 		{
 			num_segments = gs->getMinNumVerticesPerArc();
 		}
@@ -1166,13 +1155,8 @@ public:
 			num_segments = 100;
 		}
 
-		double angle = start_angle;
 		double angle_delta = opening_angle / (double)( num_segments );
-		for( int i = 0; i < num_segments+1; ++i )
-		{
-			coords.push_back( carve::geom::VECTOR( radius*cos( angle ) + x_center, radius*sin( angle ) + y_center ) );
-			angle += angle_delta;
-		}
+		GeomUtils::addEllipseArcPoints( coords, radius, radius, start_angle, angle_delta, num_segments + 1, x_center, y_center );
 	}
 
 	static void mirrorCopyPath( std::vector<vec2>& coords, bool mirror_on_y_axis, bool mirror_on_x_axis )
@@ -60,13 +60,16 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 
 #include "IncludeCarveHeaders.h"
 #include "GeometryInputData.h"
+#include "GeometryProfiler.h"
 #include "Sweeper.h"
+#include "ExtrudedOpeningSubtractor.h"
 #include "SplineConverter.h"
 #include "PointConverter.h"
 #include "CurveConverter.h"
 #include "SolidModelConverter.h"
 #include "FaceConverter.h"
 #include "ProfileCache.h"
+#include "TaskScheduler.h"
 
 struct ItemCacheContainer
 {
@@ -92,6 +95,7 @@ class RepresentationConverter : public StatusCallback
 	shared_ptr<ProfileCache>			m_profile_cache;
 	shared_ptr<FaceConverter>			m_face_converter;
 	shared_ptr<SolidModelConverter>		m_solid_converter;
+	shared_ptr<TaskScheduler>			m_task_scheduler;
 	std::map<int, shared_ptr<ItemCacheContainer> > m_itemCache;
 	bool m_geometricItemCaching = false;
 	
@@ -108,6 +112,9 @@ public:
 		m_profile_cache = shared_ptr<ProfileCache>( new ProfileCache( m_curve_converter, m_spline_converter ) );
 		m_face_converter = shared_ptr<FaceConverter>( new FaceConverter( m_geom_settings, m_unit_converter, m_curve_converter, m_spline_converter, m_sweeper, m_profile_cache ) );
 		m_solid_converter = shared_ptr<SolidModelConverter>( new SolidModelConverter( m_geom_settings, m_point_converter, m_curve_converter, m_face_converter, m_profile_cache, m_sweeper, m_styles_converter ) );
+		m_task_scheduler = shared_ptr<TaskScheduler>( new TaskScheduler( m_geom_settings->getNumThreads() ) );
+		m_task_scheduler->setIdleFunction( []() { carve::mesh::release_cached_blocks(); } );
+		m_geom_settings->m_task_scheduler = m_task_scheduler;
 		
 		// this redirects the callback messages from all converters to RepresentationConverter's callback
 		m_styles_converter->setMessageTarget( this );
@@ -130,6 +137,7 @@ public:
 	{
 		m_profile_cache->clearProfileCache();
 		m_styles_converter->clearStylesCache();
+		m_placement_converter->clearPlacementCache();
 	}
 	shared_ptr<GeometrySettings>&		getGeomSettings()	{ return m_geom_settings; }
 	shared_ptr<UnitConverter>&			getUnitConverter() { return m_unit_converter; }
@@ -140,6 +148,7 @@ public:
 	shared_ptr<PlacementConverter>&		getPlacementConverter() { return m_placement_converter; }
 	shared_ptr<CurveConverter>&			getCurveConverter() { return m_curve_converter; }
 	shared_ptr<ProfileCache>&			getProfileCache()	{ return m_profile_cache; }
+	shared_ptr<TaskScheduler>&			getTaskScheduler()	{ return m_task_scheduler; }
 	shared_ptr<FaceConverter>&			getFaceConverter() { return m_face_converter; }
 	shared_ptr<SolidModelConverter>&	getSolidConverter() { return m_solid_converter; }
 
@@ -203,133 +212,50 @@ public:
 		representationData->m_ifc_representation = ifcRepresentation;
 		printToDebugLog(__FUNC__, "");
 
-		for( const shared_ptr<IfcRepresentationItem>& representationItem : ifcRepresentation->m_Items )
+		// items of one representation are independent of each other, so they are converted as sub-tasks on the shared thread pool.
+		// A site terrain or a steel assembly with thousands of items is then no longer processed by one single thread.
+		// The results are added afterwards in the original order, so that the output does not depend on scheduling
+		const std::vector<shared_ptr<IfcRepresentationItem> >& vec_items = ifcRepresentation->m_Items;
+		std::vector<std::pair<shared_ptr<IfcRepresentationItem>, shared_ptr<ItemShapeData> > > vec_item_tasks;
+		vec_item_tasks.reserve(vec_items.size());
+		for( const shared_ptr<IfcRepresentationItem>& representationItem : vec_items )
 		{
-			//ENTITY IfcRepresentationItem  ABSTRACT SUPERTYPE OF(ONEOF(IfcGeometricRepresentationItem, IfcMappedItem, IfcStyledItem, IfcTopologicalRepresentationItem));
-			shared_ptr<IfcGeometricRepresentationItem> geomItem = dynamic_pointer_cast<IfcGeometricRepresentationItem>( representationItem );
-			if( geomItem )
+			if( representationItem )
 			{
-				shared_ptr<ItemShapeData> geomItemData( new ItemShapeData() );
-				geomItemData->m_product = representationData->m_product;
-
-				try
-				{
-					convertIfcGeometricRepresentationItem( geomItem, geomItemData );
-					representationData->addGeometricChildItem(geomItemData, representationData);
-				}
-				catch( BuildingException& e )
-				{
-					messageCallback( e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", representationItem.get() );
-				}
-				catch( std::exception& e )
-				{
-					messageCallback( e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, representationItem.get() );
-				}
-
-				continue;
+				vec_item_tasks.push_back({ representationItem, shared_ptr<ItemShapeData>() });
 			}
+		}
 
-			shared_ptr<IfcMappedItem> mapped_item = dynamic_pointer_cast<IfcMappedItem>( representationItem );
-			if( mapped_item )
+		m_task_scheduler->parallelForEach( vec_item_tasks.begin(), vec_item_tasks.end(), [&](std::pair<shared_ptr<IfcRepresentationItem>, shared_ptr<ItemShapeData> >& item_task) {
+			const shared_ptr<IfcRepresentationItem>& representationItem = item_task.first;
+			try
 			{
-				shared_ptr<IfcRepresentationMap> map_source = mapped_item->m_MappingSource;
-				if( !map_source )
-				{
-					messageCallback( "MappingSource not valid", StatusCallback::MESSAGE_TYPE_WARNING, __FUNC__, representationItem.get() );
-					continue;
-				}
-				shared_ptr<IfcRepresentation> mapped_representation = map_source->m_MappedRepresentation;
-				if( !mapped_representation )
-				{
-					messageCallback( "MappingSource.MappedRepresentation not valid", StatusCallback::MESSAGE_TYPE_WARNING, __FUNC__, representationItem.get() );
-					continue;
-				}
-
-				shared_ptr<TransformData> map_matrix_target;
-				if( mapped_item->m_MappingTarget )
-				{
-					shared_ptr<IfcCartesianTransformationOperator> transform_operator = mapped_item->m_MappingTarget;
-					m_placement_converter->convertTransformationOperator( transform_operator, map_matrix_target );
-				}
-
-				shared_ptr<TransformData> map_matrix_origin;
-				shared_ptr<IfcAxis2Placement> mapping_origin_select = map_source->m_MappingOrigin;
-				if( mapping_origin_select )
-				{
-					shared_ptr<IfcPlacement> mapping_origin_placement = dynamic_pointer_cast<IfcPlacement>( mapping_origin_select );
-					if( mapping_origin_placement )
-					{
-						m_placement_converter->convertIfcPlacement( mapping_origin_placement, map_matrix_origin );
-					}
-					else
-					{
-						messageCallback( "!dynamic_pointer_cast<IfcPlacement>( mapping_origin )", StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, mapping_origin_placement.get() );
-						continue;
-					}
-				}
-
-				shared_ptr<ItemShapeData> mapped_input_data( new ItemShapeData() );
-				mapped_input_data->m_ifc_representation = mapped_representation;
-
-				try
-				{
-					convertIfcRepresentation( mapped_representation, mapped_input_data, cacheIfcItems);
-				}
-				catch( BuildingException& e )
-				{
-					messageCallback( e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "" );
-				}
-				catch( std::exception& e )
-				{
-					messageCallback( e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__ );
-				}
-
-				if( m_geom_settings->handleStyledItems() )
-				{
-					std::vector<shared_ptr<StyleData> > vec_style_data;
-					m_styles_converter->convertRepresentationStyle( representationItem, vec_style_data );
-
-					if( vec_style_data.size() > 0 )
-					{
-						for( size_t jj_style = 0; jj_style < vec_style_data.size(); ++jj_style )
-						{
-							shared_ptr<StyleData>& data = vec_style_data[jj_style];
-							if( data )
-							{
-								mapped_input_data->addStyle( data );
-							}
-						}
-					}
-				}
-
-				if( map_matrix_origin && map_matrix_target )
-				{
-					carve::math::Matrix mapped_pos(map_matrix_target->m_matrix*map_matrix_origin->m_matrix);
-					double eps = m_geom_settings->getEpsilonMergePoints();
-					mapped_input_data->applyTransformToItem(mapped_pos, eps, false);
-				}
-
-				representationData->addGeometricChildItem( mapped_input_data, representationData );
-				continue;
+				convertIfcRepresentationItem( representationItem, representationData, item_task.second, cacheIfcItems );
 			}
-
-			shared_ptr<IfcStyledItem> styled_item = dynamic_pointer_cast<IfcStyledItem>( representationItem );
-			if( styled_item )
+			catch( BuildingException& e )
 			{
-				continue;
+				messageCallback( e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", representationItem.get() );
 			}
-
-			shared_ptr<IfcTopologicalRepresentationItem> topo_item = dynamic_pointer_cast<IfcTopologicalRepresentationItem>( representationItem );
-			if( topo_item )
+			catch( carve::exception& e )
 			{
-				shared_ptr<ItemShapeData> topological_item_data( new ItemShapeData() );
-				representationData->addGeometricChildItem( topological_item_data, representationData );
-				//topological_item_data->m_ifc_representation_item = topo_item;
-				convertTopologicalRepresentationItem(topo_item, topological_item_data);
-				continue;
+				messageCallback( e.str(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, representationItem.get() );
+			}
+			catch( std::exception& e )
+			{
+				messageCallback( e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, representationItem.get() );
+			}
+			catch( ... )
+			{
+				messageCallback( "undefined error", StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, representationItem.get() );
 			}
+		});
 
-			messageCallback( "unhandled representation", StatusCallback::MESSAGE_TYPE_WARNING, __FUNC__, representationItem.get() );
+		for( auto& item_task : vec_item_tasks )
+		{
+			if( item_task.second )
+			{
+				representationData->addGeometricChildItem( item_task.second, representationData );
+			}
 		}
 
 		//int tag = ifcRepresentation->m_tag;
@@ -385,6 +311,140 @@ public:
 		}
 	}
 
+	//\brief convertIfcRepresentationItem: converts one item of an IfcRepresentation. The result is returned in item_data_out, the caller adds it to representationData
+	// caution: this method runs in parallel threads for the items of the same representation, so representationData must not be modified here
+	void convertIfcRepresentationItem( const shared_ptr<IfcRepresentationItem>& representationItem, const shared_ptr<ItemShapeData>& representationData,
+		shared_ptr<ItemShapeData>& item_data_out, bool cacheIfcItems )
+	{
+		GeometryProfiler::ScopedItemTimer profile_item( m_geom_settings->m_profiler.get(), representationItem->classID() );
+
+		//ENTITY IfcRepresentationItem  ABSTRACT SUPERTYPE OF(ONEOF(IfcGeometricRepresentationItem, IfcMappedItem, IfcStyledItem, IfcTopologicalRepresentationItem));
+		shared_ptr<IfcGeometricRepresentationItem> geomItem = dynamic_pointer_cast<IfcGeometricRepresentationItem>( representationItem );
+		if( geomItem )
+		{
+			shared_ptr<ItemShapeData> geomItemData( new ItemShapeData() );
+			geomItemData->m_product = representationData->m_product;
+
+			try
+			{
+				convertIfcGeometricRepresentationItem( geomItem, geomItemData );
+				item_data_out = geomItemData;
+			}
+			catch( BuildingException& e )
+			{
+				messageCallback( e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", representationItem.get() );
+			}
+			catch( std::exception& e )
+			{
+				messageCallback( e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, representationItem.get() );
+			}
+
+			return;
+		}
+
+		shared_ptr<IfcMappedItem> mapped_item = dynamic_pointer_cast<IfcMappedItem>( representationItem );
+		if( mapped_item )
+		{
+			shared_ptr<IfcRepresentationMap> map_source = mapped_item->m_MappingSource;
+			if( !map_source )
+			{
+				messageCallback( "MappingSource not valid", StatusCallback::MESSAGE_TYPE_WARNING, __FUNC__, representationItem.get() );
+				return;
+			}
+			shared_ptr<IfcRepresentation> mapped_representation = map_source->m_MappedRepresentation;
+			if( !mapped_representation )
+			{
+				messageCallback( "MappingSource.MappedRepresentation not valid", StatusCallback::MESSAGE_TYPE_WARNING, __FUNC__, representationItem.get() );
+				return;
+			}
+
+			shared_ptr<TransformData> map_matrix_target;
+			if( mapped_item->m_MappingTarget )
+			{
+				shared_ptr<IfcCartesianTransformationOperator> transform_operator = mapped_item->m_MappingTarget;
+				m_placement_converter->convertTransformationOperator( transform_operator, map_matrix_target );
+			}
+
+			shared_ptr<TransformData> map_matrix_origin;
+			shared_ptr<IfcAxis2Placement> mapping_origin_select = map_source->m_MappingOrigin;
+			if( mapping_origin_select )
+			{
+				shared_ptr<IfcPlacement> mapping_origin_placement = dynamic_pointer_cast<IfcPlacement>( mapping_origin_select );
+				if( mapping_origin_placement )
+				{
+					m_placement_converter->convertIfcPlacement( mapping_origin_placement, map_matrix_origin );
+				}
+				else
+				{
+					messageCallback( "!dynamic_pointer_cast<IfcPlacement>( mapping_origin )", StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, mapping_origin_placement.get() );
+					return;
+				}
+			}
+
+			shared_ptr<ItemShapeData> mapped_input_data( new ItemShapeData() );
+			mapped_input_data->m_ifc_representation = mapped_representation;
+
+			try
+			{
+				convertIfcRepresentation( mapped_representation, mapped_input_data, cacheIfcItems);
+			}
+			catch( BuildingException& e )
+			{
+				messageCallback( e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "" );
+			}
+			catch( std::exception& e )
+			{
+				messageCallback( e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__ );
+			}
+
+			if( m_geom_settings->handleStyledItems() )
+			{
+				std::vector<shared_ptr<StyleData> > vec_style_data;
+				m_styles_converter->convertRepresentationStyle( representationItem, vec_style_data );
+
+				if( vec_style_data.size() > 0 )
+				{
+					for( size_t jj_style = 0; jj_style < vec_style_data.size(); ++jj_style )
+					{
+						shared_ptr<StyleData>& data = vec_style_data[jj_style];
+						if( data )
+						{
+							mapped_input_data->addStyle( data );
+						}
+					}
+				}
+			}
+
+			if( map_matrix_origin && map_matrix_target )
+			{
+				carve::math::Matrix mapped_pos(map_matrix_target->m_matrix*map_matrix_origin->m_matrix);
+				double eps = m_geom_settings->getEpsilonMergePoints();
+				mapped_input_data->applyTransformToItem(mapped_pos, eps, false);
+			}
+
+			item_data_out = mapped_input_data;
+			return;
+		}
+
+		shared_ptr<IfcStyledItem> styled_item = dynamic_pointer_cast<IfcStyledItem>( representationItem );
+		if( styled_item )
+		{
+			return;
+		}
+
+		shared_ptr<IfcTopologicalRepresentationItem> topo_item = dynamic_pointer_cast<IfcTopologicalRepresentationItem>( representationItem );
+		if( topo_item )
+		{
+			shared_ptr<ItemShapeData> topological_item_data( new ItemShapeData() );
+			//topological_item_data->m_ifc_representation_item = topo_item;
+			convertTopologicalRepresentationItem(topo_item, topological_item_data);
+			item_data_out = topological_item_data;
+			return;
+		}
+
+		messageCallback( "unhandled representation", StatusCallback::MESSAGE_TYPE_WARNING, __FUNC__, representationItem.get() );
+	}
+
 	void convertIfcGeometricRepresentationItem( const shared_ptr<IfcGeometricRepresentationItem>& geom_item, shared_ptr<ItemShapeData>& item_data)
 	{
 		//ENTITY IfcGeometricRepresentationItem
@@ -898,28 +958,112 @@ public:
 		}
 	}
 
+	void collectClosedMeshSets(const shared_ptr<ItemShapeData>& geom_item, std::vector<shared_ptr<carve::mesh::MeshSet<3> >* >& vec_meshsets)
+	{
+		for (shared_ptr<carve::mesh::MeshSet<3> >& meshset : geom_item->m_meshsets)
+		{
+			vec_meshsets.push_back(&meshset);
+		}
+
+		for (const shared_ptr<ItemShapeData>& child_item : geom_item->m_child_items)
+		{
+			if (child_item)
+			{
+				collectClosedMeshSets(child_item, vec_meshsets);
+			}
+		}
+	}
+
 	void subtractOpeningFromProductShape(const shared_ptr<ItemShapeData>& productShapeItem, std::vector<shared_ptr<carve::mesh::MeshSet<3> > >& vec_opening_meshes, const shared_ptr<IfcElement>& ifc_element)
 	{
-		for (size_t i_product_meshset = 0; i_product_meshset < productShapeItem->m_meshsets.size(); ++i_product_meshset)
+		// each meshset of the item (and its child items) is cut independently, so the subtractions run as sub-tasks on the shared thread pool.
+		// The boolean operations orient, validate and recalc the opening meshes in place, so with more than one task, each task works on its own copies
+		std::vector<shared_ptr<carve::mesh::MeshSet<3> >* > vec_product_meshsets;
+		collectClosedMeshSets(productShapeItem, vec_product_meshsets);
+		const bool copyOpeningMeshes = vec_product_meshsets.size() > 1;
+
+		m_task_scheduler->parallelForEach( vec_product_meshsets.begin(), vec_product_meshsets.end(), [&](shared_ptr<carve::mesh::MeshSet<3> >* product_meshset) {
+			try
+			{
+				GeomProcessingParams params(m_geom_settings);
+				params.callbackFunc = this;
+				params.ifc_entity = ifc_element.get();
+
+				std::vector<shared_ptr<carve::mesh::MeshSet<3> > > vec_opening_meshes_copy;
+				if (copyOpeningMeshes)
+				{
+					for (const shared_ptr<carve::mesh::MeshSet<3> >& opening_meshset : vec_opening_meshes)
+					{
+						vec_opening_meshes_copy.push_back(shared_ptr<carve::mesh::MeshSet<3> >(opening_meshset->clone()));
+					}
+				}
+				std::vector<shared_ptr<carve::mesh::MeshSet<3> > >& vec_task_opening_meshes = copyOpeningMeshes ? vec_opening_meshes_copy : vec_opening_meshes;
+
+				if (m_geom_settings->isSubtractExtrudedOpenings2D())
+				{
+					// openings along the direction of a prismatic element are subtracted in 2D, the remaining ones with the general CSG
+					std::vector<shared_ptr<carve::mesh::MeshSet<3> > > vec_remaining_opening_meshes;
+					ExtrudedOpeningSubtractor::subtractExtrudedOpenings(*product_meshset, vec_task_opening_meshes, vec_remaining_opening_meshes, m_sweeper, params);
+					if (vec_remaining_opening_meshes.size() > 0)
+					{
+						CSG_Adapter::computeCSG(*product_meshset, vec_remaining_opening_meshes, carve::csg::CSG::A_MINUS_B, params);
+					}
+					return;
+				}
+				CSG_Adapter::computeCSG(*product_meshset, vec_task_opening_meshes, carve::csg::CSG::A_MINUS_B, params);
+			}
+			catch (BuildingException& e)
+			{
+				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", ifc_element.get());
+			}
+			catch (carve::exception& e)
+			{
+				messageCallback(e.str(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, ifc_element.get());
+			}
+			catch (std::exception& e)
+			{
+				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, ifc_element.get());
+			}
+			catch (...)
+			{
+				messageCallback("undefined error", StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, ifc_element.get());
+			}
+		});
+	}
+
+	void convertOpeningShape(const shared_ptr<IfcFeatureElementSubtraction>& opening, shared_ptr<ProductShapeData>& product_shape_opening, const shared_ptr<IfcElement>& ifc_element)
+	{
+		// opening can have its own relative placement
+		shared_ptr<IfcObjectPlacement>	opening_placement = opening->m_ObjectPlacement;
+		if (opening->m_GlobalId)
+		{
+			product_shape_opening->m_entity_guid = opening->m_GlobalId->m_value;
+		}
+		if (opening_placement)
 		{
-			// go through all meshsets of the item
-			shared_ptr<carve::mesh::MeshSet<3> >& product_meshset = productShapeItem->m_meshsets[i_product_meshset];
-
-			// do the subtraction
-			GeomProcessingParams params(m_geom_settings);
-			params.callbackFunc = this;
-			params.ifc_entity = ifc_element.get();
-			CSG_Adapter::computeCSG(product_meshset, vec_opening_meshes, carve::csg::CSG::A_MINUS_B, params);
+			std::unordered_set<IfcObjectPlacement*> opening_placements_applied;
+			m_placement_converter->convertIfcObjectPlacement(opening_placement, product_shape_opening, opening_placements_applied, false);
 		}
 
-		for (const shared_ptr<ItemShapeData>& product_item_data : productShapeItem->m_child_items )
+		for (shared_ptr<IfcRepresentation> ifc_opening_representation : opening->m_Representation->m_Representations)
 		{
-			if (!product_item_data)
+			shared_ptr<ItemShapeData> opening_item(new ItemShapeData());
+
+			try
 			{
-				continue;
+				bool clearIfcItems = false;  // IfcOpening might be referenced several times
+				convertIfcRepresentation(ifc_opening_representation, opening_item, clearIfcItems);
+			}
+			catch (BuildingException& e)
+			{
+				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", ifc_element.get());
+			}
+			catch (std::exception& e)
+			{
+				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", ifc_element.get());
 			}
 
-			subtractOpeningFromProductShape(product_item_data, vec_opening_meshes, ifc_element);
+			product_shape_opening->addGeometricItem(opening_item, product_shape_opening);
 		}
 	}
 
@@ -931,14 +1075,8 @@ public:
 			return;
 		}
 
-		// convert opening representation
-		bool allOpeningsRelativeToProduct = true;
-		carve::math::Matrix product_transform = product_shape->getTransform();
-		int tag = ifc_element->m_tag;
-		double eps = m_geom_settings->getEpsilonMergePoints();
-
-		// for all items of the product shape, subtract all items of all related openings
-		for (const shared_ptr<ItemShapeData>& productShapeItem : product_shape->getGeometricItems() )
+		bool productHasMeshes = false;
+		for (const shared_ptr<ItemShapeData>& productShapeItem : product_shape->getGeometricItems())
 		{
 			if (!productShapeItem)
 			{
@@ -947,115 +1085,125 @@ public:
 
 			std::vector<shared_ptr<carve::mesh::MeshSet<3> > > productShapeMeshes;
 			collectMeshes(productShapeItem, productShapeMeshes);
-			if (productShapeMeshes.size() == 0)
+			if (productShapeMeshes.size() > 0)
 			{
-				continue;
+				productHasMeshes = true;
+				break;
 			}
+		}
 
-			std::vector<shared_ptr<ProductShapeData> > vec_opening_shapes;
+		if (!productHasMeshes)
+		{
+			return;
+		}
 
-			for (auto& rel_voids_weak : vec_rel_voids)
+		// convert opening representations. The openings are independent of each other, so they are converted as sub-tasks on the shared thread pool.
+		// They are converted only once per product, and then subtracted from all items of the product
+		std::vector<std::pair<shared_ptr<IfcFeatureElementSubtraction>, shared_ptr<ProductShapeData> > > vec_opening_shapes;
+		for (auto& rel_voids_weak : vec_rel_voids)
+		{
+			if (rel_voids_weak.expired())
 			{
-				if (rel_voids_weak.expired())
-				{
-					continue;
-				}
-				shared_ptr<IfcRelVoidsElement> rel_voids(rel_voids_weak);
-				shared_ptr<IfcFeatureElementSubtraction> opening = rel_voids->m_RelatedOpeningElement;
-				if (!opening)
-				{
-					continue;
-				}
-				if (!opening->m_Representation)
-				{
-					continue;
-				}
-
-				// opening can have its own relative placement
-
-				shared_ptr<IfcObjectPlacement>	opening_placement = opening->m_ObjectPlacement;
-				shared_ptr<ProductShapeData> product_shape_opening(new ProductShapeData());
-				if (opening->m_GlobalId)
-				{
-					product_shape_opening->m_entity_guid = opening->m_GlobalId->m_value;
-				}
-				if (opening_placement)
-				{
-					std::unordered_set<IfcObjectPlacement*> opening_placements_applied;
-					m_placement_converter->convertIfcObjectPlacement(opening_placement, product_shape_opening, opening_placements_applied, false);
-				}
+				continue;
+			}
+			shared_ptr<IfcRelVoidsElement> rel_voids(rel_voids_weak);
+			shared_ptr<IfcFeatureElementSubtraction> opening = rel_voids->m_RelatedOpeningElement;
+			if (!opening)
+			{
+				continue;
+			}
+			if (!opening->m_Representation)
+			{
+				continue;
+			}
+			vec_opening_shapes.push_back({ opening, shared_ptr<ProductShapeData>(new ProductShapeData()) });
+		}
 
-				for (shared_ptr<IfcRepresentation> ifc_opening_representation : opening->m_Representation->m_Representations)
-				{
-					shared_ptr<ItemShapeData> opening_item(new ItemShapeData());
+		m_task_scheduler->parallelForEach( vec_opening_shapes.begin(), vec_opening_shapes.end(), [&](std::pair<shared_ptr<IfcFeatureElementSubtraction>, shared_ptr<ProductShapeData> >& opening_task) {
+			try
+			{
+				convertOpeningShape(opening_task.first, opening_task.second, ifc_element);
+			}
+			catch (BuildingException& e)
+			{
+				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", ifc_element.get());
+			}
+			catch (carve::exception& e)
+			{
+				messageCallback(e.str(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, ifc_element.get());
+			}
+			catch (std::exception& e)
+			{
+				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, ifc_element.get());
+			}
+			catch (...)
+			{
+				messageCallback("undefined error", StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, ifc_element.get());
+			}
+		});
 
-					try
-					{
-						bool clearIfcItems = false;  // IfcOpening might be referenced several times
-						convertIfcRepresentation(ifc_opening_representation, opening_item, clearIfcItems);
-					}
-					catch (BuildingException& e)
-					{
-						messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", ifc_element.get());
-					}
-					catch (std::exception& e)
-					{
-						messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, "", ifc_element.get());
-					}
+		bool allOpeningsRelativeToProduct = true;
+		carve::math::Matrix product_transform = product_shape->getTransform();
+		double eps = m_geom_settings->getEpsilonMergePoints();
 
-					product_shape_opening->addGeometricItem(opening_item, product_shape_opening);
-				}
+		for (auto& opening_task : vec_opening_shapes)
+		{
+			// bring opening meshes to global position
+			carve::math::Matrix product_transform_relative = product_shape->getRelativeTransform(opening_task.second);
+			if (!GeomUtils::isMatrixIdentity(product_transform_relative))
+			{
+				allOpeningsRelativeToProduct = false;
+			}
+		}
 
-				// bring opening meshes to global position
-				carve::math::Matrix product_transform_relative = product_shape->getRelativeTransform(product_shape_opening);
-				if (!GeomUtils::isMatrixIdentity(product_transform_relative))
-				{
-					allOpeningsRelativeToProduct = false;
-				}
+		std::vector<shared_ptr<carve::mesh::MeshSet<3> > > vec_opening_meshes;
+		if (!allOpeningsRelativeToProduct)
+		{
+			product_shape->applyTransformToProduct(product_transform, eps, false, false);
+		}
 
-				vec_opening_shapes.push_back(product_shape_opening);
+		for (auto& opening_task : vec_opening_shapes)
+		{
+			shared_ptr<ProductShapeData>& product_shape_opening = opening_task.second;
+			if (allOpeningsRelativeToProduct)
+			{
+				carve::math::Matrix opening_transform_relative = product_shape_opening->getRelativeTransform(product_shape);
+				product_shape_opening->applyTransformToProduct(opening_transform_relative, eps, false, false);
 			}
-
-			std::vector<shared_ptr<carve::mesh::MeshSet<3> > > vec_opening_meshes;
-			if (!allOpeningsRelativeToProduct)
+			else
 			{
-				product_shape->applyTransformToProduct(product_transform, eps, false, false);
+				carve::math::Matrix opening_transform = product_shape_opening->getTransform();
+				product_shape_opening->applyTransformToProduct(opening_transform, eps, false, false);
 			}
 
-			for (shared_ptr<ProductShapeData>& product_shape_opening : vec_opening_shapes)
+			for (auto opening_item_data : product_shape_opening->getGeometricItems())
 			{
-				if (allOpeningsRelativeToProduct)
-				{
-					carve::math::Matrix opening_transform_relative = product_shape_opening->getRelativeTransform(product_shape);
-					product_shape_opening->applyTransformToProduct(opening_transform_relative, eps, false, false);
-				}
-				else
-				{
-					carve::math::Matrix opening_transform = product_shape_opening->getTransform();
-					product_shape_opening->applyTransformToProduct(opening_transform, eps, false, false);
-				}
-
-				for (auto opening_item_data : product_shape_opening->getGeometricItems())
-				{
-					collectMeshes(opening_item_data, vec_opening_meshes);
-				}
+				collectMeshes(opening_item_data, vec_opening_meshes);
 			}
+		}
 
+		// for all items of the product shape, subtract all items of all related openings
+		for (const shared_ptr<ItemShapeData>& productShapeItem : product_shape->getGeometricItems())
+		{
+			if (!productShapeItem)
+			{
+				continue;
+			}
 			subtractOpeningFromProductShape(productShapeItem, vec_opening_meshes, ifc_element);
+		}
 
-			if (!allOpeningsRelativeToProduct)
+		if (!allOpeningsRelativeToProduct)
+		{
+			carve::math::Matrix product_matrix_inverse;
+			try
 			{
-				carve::math::Matrix product_matrix_inverse;
-				try
-				{
-					GeomUtils::computeInverse(product_transform, product_matrix_inverse, 0.01 / m_unit_converter->getCustomLengthFactor());
-				}
-				catch (std::exception& e)
-				{
-					messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, ifc_element.get());
-				}
-				product_shape->applyTransformToProduct(product_matrix_inverse, eps, false, false);
+				GeomUtils::computeInverse(product_transform, product_matrix_inverse, 0.01 / m_unit_converter->getCustomLengthFactor());
+			}
+			catch (std::exception& e)
+			{
+				messageCallback(e.what(), StatusCallback::MESSAGE_TYPE_ERROR, __FUNC__, ifc_element.get());
 			}
+			product_shape->applyTransformToProduct(product_matrix_inverse, eps, false, false);
 		}
 	}
 
@@ -38,6 +38,7 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 #include <IfcIndexedColourMap.h>
 #include <IfcIndexedPolygonalFaceWithVoids.h>
 #include <IfcManifoldSolidBrep.h>
+#include <IfcPlane.h>
 #include <IfcPolygonalBoundedHalfSpace.h>
 #include <IfcPolygonalFaceSet.h>
 #include <IfcRectangularPyramid.h>
@@ -56,6 +57,7 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OU
 #include "GeomDebugDump.h"
 #include "GeometryInputData.h"
 #include "MeshOps.h"
+#include "MeshPlaneClipper.h"
 #include "PointConverter.h"
 #include "ProfileCache.h"
 #include "FaceConverter.h"
@@ -510,6 +512,22 @@ void SolidModelConverter::convertRevolvedAreaSolid( const std::vector<std::vecto
 
 	// TODO: calculate num segments according to length/width/height ratio and overall size of the object
 	int num_segments = m_geom_settings->getNumVerticesPerCircle()*(std::abs( revolution_angle ) / (2.0*M_PI));
+	if( m_geom_settings->isAdaptiveTessellation() )
+	{
+		// the profile point with the largest distance to the axis has the largest chordal deviation
+		double max_radius = 0;
+		for( const std::vector<vec2>& loop : profile_coords )
+		{
+			for( const vec2& point_2d : loop )
+			{
+				vec3 point_3d = carve::geom::VECTOR( point_2d.x, point_2d.y, 0 );
+				vec3 closest_on_axis = point_3d;
+				GeomUtils::closestPointOnLine( point_3d, axis_location, axis_direction, closest_on_axis );
+				max_radius = std::max( max_radius, ( point_3d - closest_on_axis ).length() );
+			}
+		}
+		num_segments = m_geom_settings->getNumVerticesPerArc( max_radius, revolution_angle ) - 1;
+	}
 	if( num_segments < 6 )
 	{
 		num_segments = 6;
@@ -840,9 +858,48 @@ void SolidModelConverter::convertIfcBooleanResult( const shared_ptr<IfcBooleanRe
 	shared_ptr<ItemShapeData> empty_operand;
 	convertIfcBooleanOperand( ifc_first_operand, first_operand_data, empty_operand );
 
+	// IfcBooleanClippingResult: cut the first operand directly by the plane of the half space. Only meshsets where that is not possible go through the general CSG
+	std::vector<shared_ptr<carve::mesh::MeshSet<3> > >& vec_first_operand_meshsets = first_operand_data->m_meshsets;
+	std::vector<bool> vec_needs_csg(vec_first_operand_meshsets.size(), true);
+	shared_ptr<IfcHalfSpaceSolid> half_space_solid = dynamic_pointer_cast<IfcHalfSpaceSolid>(ifc_second_operand);
+	if (half_space_solid && csg_operation == carve::csg::CSG::A_MINUS_B)
+	{
+		carve::geom::plane<3> clipping_plane;
+		std::vector<vec2> boundary_polygon;
+		carve::math::Matrix boundary_position_inverse;
+		if (getHalfSpaceClippingPlane(half_space_solid, clipping_plane, boundary_polygon, boundary_position_inverse))
+		{
+			GeomProcessingParams params(m_geom_settings, bool_result.get(), this);
+			for (size_t i_meshset_first = 0; i_meshset_first < vec_first_operand_meshsets.size(); ++i_meshset_first)
+			{
+				shared_ptr<carve::mesh::MeshSet<3> >& first_operand_meshset = vec_first_operand_meshsets[i_meshset_first];
+				if (!first_operand_meshset)
+				{
+					continue;
+				}
+				if (boundary_polygon.size() > 0)
+				{
+					// a bounded half space is a plain half space only if the meshset is completely inside the boundary
+					if (!MeshPlaneClipper::isInsidePolygonPrism(first_operand_meshset, boundary_polygon, boundary_position_inverse, params.epsMergePoints))
+					{
+						continue;
+					}
+				}
+
+				if (MeshPlaneClipper::clipMeshSet(first_operand_meshset, clipping_plane, params))
+				{
+					vec_needs_csg[i_meshset_first] = false;
+				}
+			}
+		}
+	}
+
 	// convert the second operand
 	shared_ptr<ItemShapeData> second_operand_data( new ItemShapeData() );
-	convertIfcBooleanOperand( ifc_second_operand, second_operand_data, first_operand_data );
+	if (std::find(vec_needs_csg.begin(), vec_needs_csg.end(), true) != vec_needs_csg.end())
+	{
+		convertIfcBooleanOperand(ifc_second_operand, second_operand_data, first_operand_data);
+	}
 
 	//vec4 color(0.5, 0.5, 0.5, 1.);
 	//GeomDebugDump::dumpItemShapeInputData(first_operand_data, color);
@@ -867,12 +924,11 @@ void SolidModelConverter::convertIfcBooleanResult( const shared_ptr<IfcBooleanRe
 #endif
 
 	// for every first operand polyhedrons, apply all second operand polyhedrons
-	std::vector<shared_ptr<carve::mesh::MeshSet<3> > >& vec_first_operand_meshsets = first_operand_data->m_meshsets;
 	for( size_t i_meshset_first = 0; i_meshset_first < vec_first_operand_meshsets.size(); ++i_meshset_first )
 	{
 		shared_ptr<carve::mesh::MeshSet<3> >& first_operand_meshset = vec_first_operand_meshsets[i_meshset_first];
 
-		if (!first_operand_meshset)
+		if (!first_operand_meshset || !vec_needs_csg[i_meshset_first])
 		{
 			continue;
 		}
@@ -883,8 +939,9 @@ void SolidModelConverter::convertIfcBooleanResult( const shared_ptr<IfcBooleanRe
 		CSG_Adapter::computeCSG(first_operand_meshset, vec_second_operand_meshsets, csg_operation, params);
 	}
 
-	// now copy processed first operands to result input data
-	std::copy( first_operand_data->m_meshsets.begin(), first_operand_data->m_meshsets.end(), std::back_inserter( item_data->m_meshsets ) );
+	// now copy processed first operands to result input data. Meshsets that were completely clipped away are null
+	std::copy_if( first_operand_data->m_meshsets.begin(), first_operand_data->m_meshsets.end(), std::back_inserter( item_data->m_meshsets ),
+		[](const shared_ptr<carve::mesh::MeshSet<3> >& meshset) { return meshset != nullptr; } );
 
 	// copy also styles from operands, if any
 	std::copy(first_operand_data->m_styles.begin(), first_operand_data->m_styles.end(), std::back_inserter(item_data->m_styles));
@@ -1042,12 +1099,11 @@ void SolidModelConverter::convertIfcCsgPrimitive3D( const shared_ptr<IfcCsgPrimi
 		polyhedron_data->addVertex( primitive_placement_matrix*carve::geom::VECTOR( 0.0, 0.0, height ) ); // top
 		polyhedron_data->addVertex( primitive_placement_matrix*carve::geom::VECTOR( 0.0, 0.0, 0.0 ) ); // bottom center
 
-		double angle = 0;
 		double d_angle = 2.0*M_PI / double(m_geom_settings->getNumVerticesPerCircleWithRadius(radius) );
+		const GeomUtils::UnitCircleTable& circleTable = GeomUtils::getUnitCircleTable(m_geom_settings->getNumVerticesPerCircleWithRadius(radius), d_angle);
 		for( int i = 0; i < m_geom_settings->getNumVerticesPerCircleWithRadius(radius); ++i )
 		{
-			polyhedron_data->addVertex( primitive_placement_matrix*carve::geom::VECTOR( sin( angle )*radius, cos( angle )*radius, 0.0 ) );
-			angle += d_angle;
+			polyhedron_data->addVertex( primitive_placement_matrix*carve::geom::VECTOR( circleTable.sinValues[i]*radius, circleTable.cosValues[i]*radius, 0.0 ) );
 		}
 
 		// outer shape
@@ -1086,16 +1142,15 @@ void SolidModelConverter::convertIfcCsgPrimitive3D( const shared_ptr<IfcCsgPrimi
 		double height = right_circular_cylinder->m_Height->m_value*length_factor;
 		double radius = right_circular_cylinder->m_Radius->m_value*length_factor;
 
-		double angle = 0;
 		const size_t num_points = m_geom_settings->getNumVerticesPerCircleWithRadius(radius);
 		const double d_angle = 2.0*M_PI / double( num_points );	// TODO: adapt to model size and complexity
+		const GeomUtils::UnitCircleTable& circleTable = GeomUtils::getUnitCircleTable(num_points, d_angle);
 		for( int i = 0; i < num_points; ++i )
 		{
-			double x = cos( angle )*radius;
-			double y = sin( angle )*radius;
+			double x = circleTable.cosValues[i]*radius;
+			double y = circleTable.sinValues[i]*radius;
 			polyhedron_data->addVertex( primitive_placement_matrix*carve::geom::VECTOR( x, y, height ) );
 			polyhedron_data->addVertex( primitive_placement_matrix*carve::geom::VECTOR( x, y, 0.0 ) );
-			angle += d_angle;
 		}
 
 		for( size_t i = 0; i < num_points; ++i )
@@ -1218,6 +1273,65 @@ void SolidModelConverter::extrudeBox( const std::vector<vec3>& boundary_points,
 	box_data->addFace( 7, 3, 2 );
 }
 
+bool SolidModelConverter::getHalfSpaceClippingPlane( const shared_ptr<IfcHalfSpaceSolid>& half_space_solid, carve::geom::plane<3>& clipping_plane, std::vector<vec2>& boundary_polygon, carve::math::Matrix& boundary_position_inverse )
+{
+	// IfcBoxedHalfSpace is converted to its enclosure box, keep that
+	if( dynamic_pointer_cast<IfcBoxedHalfSpace>( half_space_solid ) )
+	{
+		return false;
+	}
+
+	shared_ptr<IfcElementarySurface> elem_base_surface = dynamic_pointer_cast<IfcElementarySurface>( half_space_solid->m_BaseSurface );
+	if( !elem_base_surface || !elem_base_surface->m_Position || !half_space_solid->m_AgreementFlag )
+	{
+		return false;
+	}
+
+	// only planes can be used for clipping, other elementary surfaces (cylinder, sphere) need the general CSG
+	if( !dynamic_pointer_cast<IfcPlane>( elem_base_surface ) )
+	{
+		return false;
+	}
+
+	vec3 base_surface_position;
+	m_curve_converter->getPlacementConverter()->getPlane( elem_base_surface->m_Position, clipping_plane, base_surface_position );
+
+	// If the agreement flag is TRUE, then the half space solid is the side the normal points away from. The clipping removes that negative side
+	if( !half_space_solid->m_AgreementFlag->m_value )
+	{
+		clipping_plane.negate();
+	}
+
+	shared_ptr<IfcPolygonalBoundedHalfSpace> polygonal_half_space = dynamic_pointer_cast<IfcPolygonalBoundedHalfSpace>( half_space_solid );
+	if( polygonal_half_space )
+	{
+		carve::math::Matrix boundary_position_matrix( carve::math::Matrix::IDENT() );
+		if( polygonal_half_space->m_Position )
+		{
+			shared_ptr<TransformData> boundary_transform;
+			m_curve_converter->getPlacementConverter()->convertIfcAxis2Placement3D( polygonal_half_space->m_Position, boundary_transform );
+			if( boundary_transform )
+			{
+				boundary_position_matrix = boundary_transform->m_matrix;
+			}
+		}
+
+		std::vector<vec2> segment_start_points_2d;
+		m_curve_converter->convertIfcCurve2D( polygonal_half_space->m_PolygonalBoundary, boundary_polygon, segment_start_points_2d, true );
+		GeomUtils::unClosePolygon( boundary_polygon, m_geom_settings->getEpsilonMergePoints() );
+		if( boundary_polygon.size() < 3 )
+		{
+			return false;
+		}
+
+		if( !GeomUtils::computeInverse( boundary_position_matrix, boundary_position_inverse ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 void SolidModelConverter::convertIfcHalfSpaceSolid( const shared_ptr<IfcHalfSpaceSolid>& half_space_solid, shared_ptr<ItemShapeData>& item_data, const shared_ptr<ItemShapeData>& other_operand )
 {
 	//ENTITY IfcHalfSpaceSolid SUPERTYPE OF(ONEOF(IfcBoxedHalfSpace, IfcPolygonalBoundedHalfSpace))
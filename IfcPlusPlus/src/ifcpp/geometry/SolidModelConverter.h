@@ -66,6 +66,10 @@ public:
 
 	void extrudeBox(const std::vector<vec3>& boundary_points, const vec3& extrusion_vector, shared_ptr<carve::input::PolyhedronData>& box_data);
 
+	/**\brief getHalfSpaceClippingPlane: plane of a half space solid with a planar base surface, oriented so that MeshPlaneClipper keeps the part outside of the half space.
+	For IfcPolygonalBoundedHalfSpace, also the 2D boundary polygon and the inverse of its position are returned. Returns false for other half spaces */
+	bool getHalfSpaceClippingPlane(const shared_ptr<IfcHalfSpaceSolid>& half_space_solid, carve::geom::plane<3>& clipping_plane, std::vector<vec2>& boundary_polygon, carve::math::Matrix& boundary_position_inverse);
+
 	void convertIfcHalfSpaceSolid(const shared_ptr<IfcHalfSpaceSolid>& half_space_solid, shared_ptr<ItemShapeData>& item_data, const shared_ptr<ItemShapeData>& other_operand);
 
 	void copyIndexedFaceLoop(const std::vector<shared_ptr<IfcPositiveInteger> >& vecIdx, const std::vector<vec3>& vecPointsIn, std::vector<vec3>& vecOut);
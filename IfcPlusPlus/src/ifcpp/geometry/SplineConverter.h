@@ -206,6 +206,73 @@ public:
 		}
 	}
 
+	/**\brief computeAdaptiveBSpline: samples the curve uniformly in parameter space. The number of points is doubled until the polyline is within the
+	tessellation tolerances of GeometrySettings. The polyline is checked against the points in between, which are computed with the next finer sampling anyway */
+	void computeAdaptiveBSpline( const size_t order, const std::vector<vec3>& controlPoints, std::vector<double>& weights, std::vector<double>& knotVec, std::vector<double>& curvePoints ) const
+	{
+		const double maxDeviation = m_geom_settings->getMaxChordalDeviation();
+		const double maxAngle = m_geom_settings->getMaxAngleDeviation();
+		const size_t maxNumCurvePoints = controlPoints.size() * std::max( 1, m_geom_settings->getMaxNumVerticesPerCircle() );
+
+		size_t numCurvePoints = std::max( controlPoints.size(), order + 1 );
+		curvePoints.assign( 3 * numCurvePoints, 0.0 );
+		computeRationalBSpline( order, numCurvePoints, controlPoints, weights, knotVec, curvePoints );
+
+		std::vector<double> finePoints;
+		while( 2 * numCurvePoints - 1 <= maxNumCurvePoints )
+		{
+			const size_t numFinePoints = 2 * numCurvePoints - 1;
+			finePoints.assign( 3 * numFinePoints, 0.0 );
+			computeRationalBSpline( order, numFinePoints, controlPoints, weights, knotVec, finePoints );
+
+			// even indices of the fine sampling are the current points, odd indices are in between
+			auto finePoint = [&finePoints]( size_t ii ) { return carve::geom::VECTOR( finePoints[3 * ii], finePoints[3 * ii + 1], finePoints[3 * ii + 2] ); };
+			bool withinTolerance = true;
+			for( size_t ii = 1; ii + 1 < numFinePoints && withinTolerance; ii += 2 )
+			{
+				const vec3 previous = finePoint( ii - 1 );
+				const vec3 next = finePoint( ii + 1 );
+
+				if( maxDeviation > 0 )
+				{
+					const vec3 chord = next - previous;
+					const double chordLength2 = chord.length2();
+					const vec3 between = finePoint( ii );
+					double t = chordLength2 > 0 ? carve::geom::dot( between - previous, chord ) / chordLength2 : 0;
+					t = std::min( 1.0, std::max( 0.0, t ) );
+					if( ( between - ( previous + chord*t ) ).length() > maxDeviation )
+					{
+						withinTolerance = false;
+					}
+				}
+
+				if( maxAngle > 0 && ii + 3 < numFinePoints )
+				{
+					const vec3 segment1 = next - previous;
+					const vec3 segment2 = finePoint( ii + 3 ) - next;
+					const double length1 = segment1.length();
+					const double length2 = segment2.length();
+					if( length1 > 0 && length2 > 0 )
+					{
+						double cosAngle = carve::geom::dot( segment1, segment2 ) / ( length1*length2 );
+						cosAngle = std::min( 1.0, std::max( -1.0, cosAngle ) );
+						if( std::acos( cosAngle ) > maxAngle )
+						{
+							withinTolerance = false;
+						}
+					}
+				}
+			}
+
+			if( withinTolerance )
+			{
+				break;
+			}
+			curvePoints.swap( finePoints );
+			numCurvePoints = numFinePoints;
+		}
+	}
+
 	SplineConverter( shared_ptr<GeometrySettings>& geom_settings, shared_ptr<PointConverter>& pt_converter )
 		: m_geom_settings( geom_settings ), m_point_converter( pt_converter )
 	{
@@ -238,7 +305,7 @@ public:
 		const size_t numControlPoints = controlPoints.size();
 		const int	degree = bspline_curve->m_Degree->m_value;
 		const size_t order = degree + 1; // the order of the curve is the degree of the resulting polynomial + 1
-		const size_t numCurvePoints = numControlPoints * m_geom_settings->getNumVerticesPerControlPoint();
+		size_t numCurvePoints = numControlPoints * m_geom_settings->getNumVerticesPerControlPoint();
 		std::vector<double> knotVector;
 
 		//	set weighting factors to 1.0 in case of homogeneous curve
@@ -302,8 +369,16 @@ public:
 		}
 
 		std::vector<double> curvePointsCoords;
-		curvePointsCoords.resize( 3 * numCurvePoints, 0.0 );
-		computeRationalBSpline( order, numCurvePoints, controlPoints, weights, knotVector, curvePointsCoords );
+		if( m_geom_settings->isAdaptiveTessellation() )
+		{
+			computeAdaptiveBSpline( order, controlPoints, weights, knotVector, curvePointsCoords );
+			numCurvePoints = curvePointsCoords.size() / 3;
+		}
+		else
+		{
+			curvePointsCoords.resize( 3 * numCurvePoints, 0.0 );
+			computeRationalBSpline( order, numCurvePoints, controlPoints, weights, knotVector, curvePointsCoords );
+		}
 
 		if( target_vec.size() > 2 )
 		{
@@ -250,6 +250,18 @@ public:
 			}
 			fl->area = loop_area;
 
+			if( m_geom_settings->isReportSelfIntersections() )
+			{
+				std::vector<std::pair<size_t, size_t> > intersectingSegments;
+				GeomUtils::findPolygonSelfIntersections(loopPointsInput, eps, intersectingSegments, true);
+				if( intersectingSegments.size() > 0 )
+				{
+					std::stringstream err;
+					err << "face loop is self-intersecting, segment " << intersectingSegments[0].first << " crosses segment " << intersectingSegments[0].second;
+					messageCallback(err.str().c_str(), StatusCallback::MESSAGE_TYPE_MINOR_WARNING, __FUNC__, params.ifc_entity);
+				}
+			}
+
 			if (!currentFaceLoopSet)
 			{
 				currentFaceLoopSet = make_shared<FaceLoopSet>();
@@ -655,15 +667,15 @@ public:
 			section_local_x.z,		section_local_y.z,		section_local_z.z,	0,
 			0,				0,				0,			1 );
 
-		double angle = 0;
 		double delta_angle = 2.0*M_PI/double(nvc);	// TODO: adapt to model size and complexity
+		const GeomUtils::UnitCircleTable& circleTable = GeomUtils::getUnitCircleTable(nvc, delta_angle);
 		std::vector<vec3> circle_points(nvc);
 		std::vector<vec3> circle_points_inner(nvc);
 		for( size_t ii = 0; ii < nvc; ++ii )
 		{
 			// cross section (circle) is defined in XY plane
-			double x = sin(angle);
-			double y = cos(angle);
+			double x = circleTable.sinValues[ii];
+			double y = circleTable.cosValues[ii];
 			vec3 vertex( carve::geom::VECTOR( x*radius, y*radius, 0.0 ) );
 			vertex = matrix_first_direction*vertex + curve_point_first;
 			circle_points[ii] = vertex;
@@ -674,7 +686,6 @@ public:
 				vertex_inner = matrix_first_direction*vertex_inner + curve_point_first;
 				circle_points_inner[ii] = vertex_inner;
 			}
-			angle += delta_angle;
 		}
 
 		shared_ptr<carve::input::PolyhedronData> poly_data( new carve::input::PolyhedronData() );
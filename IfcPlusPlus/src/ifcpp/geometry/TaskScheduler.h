@@ -0,0 +1,347 @@
+/* -*-c++-*- IfcQuery www.ifcquery.com
+*
+MIT License
+
+Copyright (c) 2017 Fabian Gerold
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <ifcpp/model/BasicTypes.h>
+
+/**
+*\brief Class TaskScheduler: bounded thread pool for geometry conversion.
+* parallelForEach hands out the elements strictly in the given order, so a range sorted by cost is processed largest-first.
+* The calling thread takes part in the work, and while it waits for other threads, it executes queued tasks itself.
+* That way, parallelForEach can be nested (products -> representations -> items) without blocking the pool, and the total
+* number of threads never exceeds getNumThreads().
+* A waiting thread only helps with tasks nested in the elements it waits for, never with other products. Threads take the
+* most recently queued task first, so nested work is finished before new outer elements are started.
+*/
+class TaskScheduler
+{
+public:
+	//\brief numThreads: maximum number of threads working in parallel, including the calling thread. 0 means std::thread::hardware_concurrency
+	TaskScheduler(size_t numThreads = 0)
+	{
+		setNumThreads(numThreads);
+	}
+
+	~TaskScheduler()
+	{
+		stopWorkers();
+	}
+
+	size_t getNumThreads() const { return m_num_threads; }
+
+	//\brief setNumThreads: must not be called while a parallelForEach is running
+	void setNumThreads(size_t numThreads)
+	{
+		if (numThreads == 0)
+		{
+			numThreads = std::thread::hardware_concurrency();
+			if (numThreads == 0)
+			{
+				numThreads = 1;
+			}
+		}
+
+		if (numThreads == m_num_threads)
+		{
+			return;
+		}
+
+		stopWorkers();
+		m_num_threads = numThreads;
+
+		// the calling thread of parallelForEach is the n-th thread
+		for (size_t ii = 1; ii < m_num_threads; ++ii)
+		{
+			m_workers.push_back(std::thread(&TaskScheduler::workerLoop, this));
+		}
+	}
+
+	//\brief setIdleFunction: called by a worker thread that found no work for 100 ms, for example to release thread local caches
+	void setIdleFunction(const std::function<void()>& func)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex_queue);
+		m_idle_function = func;
+	}
+
+	/*\brief parallelForEach: calls func for each element in [begin, end), in parallel. Elements are picked up in order of the range.
+	* If func throws, the remaining elements are still processed, then the first exception is rethrown in the calling thread.
+	**/
+	template<typename TIterator, typename TFunction>
+	void parallelForEach(TIterator begin, TIterator end, TFunction func)
+	{
+		const size_t numElements = std::distance(begin, end);
+		if (numElements == 0)
+		{
+			return;
+		}
+
+		ExceptionCollector exceptions;
+#if defined(_DEBUG_LOOP_SEQENTIAL) || defined(_DEBUG)
+		for (TIterator it = begin; it != end; ++it)
+		{
+			runElement(func, *it, exceptions);
+		}
+		exceptions.rethrow();
+#else
+		if (numElements == 1 || m_num_threads < 2)
+		{
+			for (TIterator it = begin; it != end; ++it)
+			{
+				runElement(func, *it, exceptions);
+			}
+			exceptions.rethrow();
+			return;
+		}
+
+		struct Batch
+		{
+			std::atomic<size_t> next_index{ 0 };
+			std::atomic<size_t> num_done{ 0 };
+			ExceptionCollector exceptions;
+			shared_ptr<BatchNode> node;
+		};
+		shared_ptr<Batch> batch = make_shared<Batch>();
+		batch->node = make_shared<BatchNode>();
+		batch->node->parent = currentBatch();
+
+		auto runner = [this, batch, begin, numElements, &func]()
+		{
+			shared_ptr<const BatchNode> previousBatch = currentBatch();
+			currentBatch() = batch->node;
+			while (true)
+			{
+				size_t index = batch->next_index.fetch_add(1);
+				if (index >= numElements)
+				{
+					break;
+				}
+				runElement(func, *(begin + index), batch->exceptions);
+				if (batch->num_done.fetch_add(1) + 1 == numElements)
+				{
+					// wake up the thread that waits for this batch
+					std::lock_guard<std::mutex> lock(m_mutex_queue);
+					m_condition_queue.notify_all();
+				}
+			}
+			currentBatch() = previousBatch;
+		};
+
+		// one runner per available worker. Runners that are picked up after all elements are taken return immediately
+		size_t numRunners = std::min(numElements, m_num_threads) - 1;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex_queue);
+			for (size_t ii = 0; ii < numRunners; ++ii)
+			{
+				m_queue.push_back({ runner, batch->node });
+			}
+		}
+		m_condition_queue.notify_all();
+
+		runner();
+
+		// help with queued tasks of this batch and of batches nested in its elements, until all elements are done
+		const BatchNode* waitingBatch = batch->node.get();
+		while (batch->num_done.load() < numElements)
+		{
+			if (!runQueuedTask(waitingBatch))
+			{
+				std::unique_lock<std::mutex> lock(m_mutex_queue);
+				m_condition_queue.wait_for(lock, std::chrono::milliseconds(1), [this, &batch, numElements, waitingBatch] { return batch->num_done.load() >= numElements || findQueuedTask(waitingBatch) != m_queue.end(); });
+			}
+		}
+		batch->exceptions.rethrow();
+#endif
+	}
+
+	//\brief parallelFor: calls func for each index in [0, numElements), in parallel
+	void parallelFor(size_t numElements, const std::function<void(size_t)>& func)
+	{
+		std::vector<size_t> indices(numElements);
+		for (size_t ii = 0; ii < numElements; ++ii)
+		{
+			indices[ii] = ii;
+		}
+		parallelForEach(indices.begin(), indices.end(), [&func](size_t index) { func(index); });
+	}
+
+protected:
+	//\brief BatchNode: identifies one parallelForEach call, parent is the batch whose element made the call
+	struct BatchNode
+	{
+		shared_ptr<const BatchNode> parent;
+
+		bool isNestedIn(const BatchNode* other) const
+		{
+			for (const BatchNode* node = this; node; node = node->parent.get())
+			{
+				if (node == other)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	struct QueuedTask
+	{
+		std::function<void()> func;
+		shared_ptr<const BatchNode> batch;
+	};
+
+	//\brief currentBatch: batch of the element that the calling thread is working on, nullptr outside of parallelForEach
+	static shared_ptr<const BatchNode>& currentBatch()
+	{
+		thread_local shared_ptr<const BatchNode> current_batch;
+		return current_batch;
+	}
+
+	//\brief ExceptionCollector: keeps the first exception thrown by the elements of one parallelForEach
+	struct ExceptionCollector
+	{
+		std::mutex mutex;
+		std::exception_ptr first;
+
+		void add(std::exception_ptr e)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!first)
+			{
+				first = e;
+			}
+		}
+
+		void rethrow()
+		{
+			if (first)
+			{
+				std::rethrow_exception(first);
+			}
+		}
+	};
+
+	template<typename TFunction, typename TElement>
+	static void runElement(TFunction& func, TElement& element, ExceptionCollector& exceptions)
+	{
+		try
+		{
+			func(element);
+		}
+		catch (...)
+		{
+			exceptions.add(std::current_exception());
+		}
+	}
+
+	//\brief findQueuedTask: most recently queued task that belongs to waitingBatch or to a batch nested in it. m_mutex_queue must be locked
+	std::deque<QueuedTask>::iterator findQueuedTask(const BatchNode* waitingBatch)
+	{
+		for (auto it = m_queue.rbegin(); it != m_queue.rend(); ++it)
+		{
+			if (it->batch && it->batch->isNestedIn(waitingBatch))
+			{
+				return std::next(it).base();
+			}
+		}
+		return m_queue.end();
+	}
+
+	bool runQueuedTask(const BatchNode* waitingBatch)
+	{
+		std::function<void()> task;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex_queue);
+			auto it = findQueuedTask(waitingBatch);
+			if (it == m_queue.end())
+			{
+				return false;
+			}
+			task = std::move(it->func);
+			m_queue.erase(it);
+		}
+		task();
+		return true;
+	}
+
+	void workerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex_queue);
+				auto hasWork = [this] { return m_stop || !m_queue.empty(); };
+				if (!m_condition_queue.wait_for(lock, std::chrono::milliseconds(100), hasWork))
+				{
+					if (m_idle_function)
+					{
+						std::function<void()> idleFunction = m_idle_function;
+						lock.unlock();
+						idleFunction();
+						lock.lock();
+					}
+					m_condition_queue.wait(lock, hasWork);
+				}
+				if (m_stop && m_queue.empty())
+				{
+					return;
+				}
+				// most recent first, so that nested tasks are finished before new outer elements are started
+				task = std::move(m_queue.back().func);
+				m_queue.pop_back();
+			}
+			task();
+		}
+	}
+
+	void stopWorkers()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex_queue);
+			m_stop = true;
+		}
+		m_condition_queue.notify_all();
+		for (std::thread& worker : m_workers)
+		{
+			if (worker.joinable())
+			{
+				worker.join();
+			}
+		}
+		m_workers.clear();
+		m_stop = false;
+	}
+
+	size_t m_num_threads = 0;
+	bool m_stop = false;
+	std::vector<std::thread> m_workers;
+	std::deque<QueuedTask> m_queue;
+	std::function<void()> m_idle_function;
+	std::mutex m_mutex_queue;
+	std::condition_variable m_condition_queue;
+};